@@ -0,0 +1,123 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "dbg_generator.h"
+
+using namespace std;
+
+static const char BASES[] = "ACGT";
+
+/**
+ * the canonical k-mers of added sequences and the oriented overlaps between them
+ */
+class KmerGraph {
+public:
+    explicit KmerGraph(int k) : k(k) {}
+
+    void add_sequence(const string &sequence) {
+        long previous_id = 0;
+        bool previous_forward = true;
+        for (size_t i = 0; i + k <= sequence.size(); ++i) {
+            bool forward;
+            long id = add_kmer(sequence.substr(i, static_cast<size_t>(k)), forward);
+            if (previous_id != 0)
+                add_edge(previous_id, previous_forward, id, forward);
+            previous_id = id;
+            previous_forward = forward;
+        }
+    }
+
+    long write(FILE *file) {
+        fprintf(file, "H\tVN:Z:1.0\n");
+        for (size_t i = 0; i < kmers.size(); ++i)
+            fprintf(file, "S\t%lu\t%s\n", i + 1, kmers[i].c_str());
+        for (uint64_t edge : edges)
+            fprintf(file, "L\t%lu\t%c\t%lu\t%c\t%dM\n", static_cast<unsigned long>(edge >> 33),
+                    edge >> 32 & 1 ? '+' : '-', static_cast<unsigned long>(edge >> 1 & 0x7fffffff),
+                    edge & 1 ? '+' : '-', k - 1);
+        return ftell(file);
+    }
+
+private:
+    static string reverse_complement(const string &sequence) {
+        string result(sequence.rbegin(), sequence.rend());
+        for (char &c : result)
+            c = c == 'A' ? 'T' : c == 'C' ? 'G' : c == 'G' ? 'C' : 'A';
+        return result;
+    }
+
+    long add_kmer(const string &kmer, bool &forward) {
+        string reverse_kmer = reverse_complement(kmer);
+        forward = kmer <= reverse_kmer;
+        const string &canonical_kmer = forward ? kmer : reverse_kmer;
+        auto inserted = ids.emplace(canonical_kmer, static_cast<long>(kmers.size() + 1));
+        if (inserted.second)
+            kmers.push_back(canonical_kmer);
+        return inserted.first->second;
+    }
+
+    static uint64_t edge_key(long from_id, bool from_forward, long to_id, bool to_forward) {
+        return static_cast<uint64_t>(from_id) << 33 | static_cast<uint64_t>(from_forward) << 32 |
+               static_cast<uint64_t>(to_id) << 1 | static_cast<uint64_t>(to_forward);
+    }
+
+    void add_edge(long from_id, bool from_forward, long to_id, bool to_forward) {
+        if (edges.count(edge_key(to_id, !to_forward, from_id, !from_forward)) == 0)
+            edges.insert(edge_key(from_id, from_forward, to_id, to_forward));
+    }
+
+    int k;
+    unordered_map<string, long> ids;
+    vector<string> kmers;
+    unordered_set<uint64_t> edges;
+};
+
+long generate_dbg(const DbgGeneratorOptions &options, const char *file_name) {
+    mt19937_64 random(options.seed);
+    int k = options.k;
+    auto random_base = [&]() { return BASES[random() % 4]; };
+    auto random_position = [&](size_t begin, size_t end) { return begin + random() % (end - begin); };
+    string genome(static_cast<size_t>(options.nodes + k - 1), 'A');
+    for (char &c : genome)
+        c = random_base();
+    KmerGraph graph(k);
+    graph.add_sequence(genome);
+    auto count = [&](double density) { return static_cast<long>(density * options.nodes); };
+    size_t k_size = static_cast<size_t>(k);
+    if (genome.size() > 3 * k_size) {
+        for (long i = count(options.bubbles); i > 0; --i) {
+            size_t position = random_position(k_size, genome.size() - k_size);
+            string variant = genome.substr(position - k_size + 1, 2 * k_size - 1);
+            char &letter = variant[k_size - 1];
+            letter = BASES[(string(BASES).find(letter) + 1 + random() % 3) % 4];
+            graph.add_sequence(variant);
+        }
+        for (long i = count(options.tips); i > 0; --i) {
+            size_t position = random_position(k_size, genome.size() - k_size);
+            string tip = genome.substr(position - k_size + 1, k_size);
+            for (size_t len = 1 + random() % (k_size / 2); len > 0; --len)
+                tip += random_base();
+            graph.add_sequence(tip);
+        }
+        for (long i = count(options.branching); i > 0; --i) {
+            size_t from_position = random_position(k_size, genome.size() - k_size);
+            size_t to_position = random_position(0, genome.size() - k_size);
+            graph.add_sequence(genome.substr(from_position - k_size + 1, k_size) + genome.substr(to_position, k_size));
+        }
+    }
+    FILE *file = fopen(file_name, "w");
+    if (!file)
+        return -1;
+    long written = graph.write(file);
+    if (fclose(file) != 0)
+        return -1;
+    return written;
+}
@@ -0,0 +1,24 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#ifndef STARK_DBG_GENERATOR_H
+#define STARK_DBG_GENERATOR_H
+
+struct DbgGeneratorOptions {
+    int k = 31;
+    long nodes = 1000000; // length of the random genome, about the number of k-mer nodes it gives
+    double branching = 0.001; // chimeric joins of two random genome positions, per genome letter
+    double tips = 0.002; // short dead-end branches, per genome letter
+    double bubbles = 0.002; // single letter variants, per genome letter
+    unsigned seed = 1;
+};
+
+/**
+ * writes the bidirected de Bruijn graph of the k-mers of a random genome, its variants, tips and chimeric joins to
+ * file_name as GFA1: one segment per canonical k-mer and one link per k-1 overlap
+ * @return the number of bytes written, or -1 if the file could not be written
+ */
+long generate_dbg(const DbgGeneratorOptions &options, const char *file_name);
+
+#endif //STARK_DBG_GENERATOR_H
@@ -0,0 +1,270 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <getopt.h>
+#include <unistd.h>
+#include "dbg_generator.h"
+#include "frozen_graph.h"
+#include "gfa_reader.h"
+#include "gfa_writer.h"
+#include "graph_phases.h"
+#include "node.h"
+#include "utils/logger.h"
+
+using namespace std;
+
+#define EDGES_BENCH_OPERATIONS      4000000L
+#define PARTIAL_MERGE_BENCH_PAIRS   200000L
+#define PARTIAL_MERGE_SEQUENCE_LEN  64
+
+extern Logger *logger;
+volatile long bench_sink; // keeps the results of benchmarked calls alive
+char *help_str = const_cast<char *>("stark_bench\nUsage: stark_bench [-k k] [-n nodes] [-b branching] [-p tips] "
+                                    "[-u bubbles] [-s seed] [-t threads] [-o gfa_file_name]\n\n"
+                                    "    -k,      --k=K                  use K for the k of the generated graph\n"
+                                    "    -n,      --nodes=N              generate about N k-mer nodes\n"
+                                    "    -b,      --branching=RATE       add RATE chimeric joins per genome letter\n"
+                                    "    -p,      --tips=RATE            add RATE tips per genome letter\n"
+                                    "    -u,      --bubbles=RATE         add RATE bubbles per genome letter\n"
+                                    "    -s,      --seed=SEED            use SEED for the generator\n"
+                                    "    -t,      --threads=N            use N threads\n"
+                                    "    -o,      --output=FILE          keep the generated graph in FILE\n\n"
+);
+
+class Timer {
+public:
+    Timer() : start(chrono::steady_clock::now()) {}
+
+    double seconds() const {
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    chrono::steady_clock::time_point start;
+};
+
+/**
+ * prints the time of a benchmark and the rates of its non-zero counts
+ */
+static void report(const char *name, double seconds, long nodes, long edges, long bytes, const char *unit = nullptr,
+                   long units = 0) {
+    printf("%-16s %9.3f s", name, seconds);
+    if (nodes > 0)
+        printf("  %12.0f nodes/s", nodes / seconds);
+    if (edges > 0)
+        printf("  %12.0f edges/s", edges / seconds);
+    if (bytes > 0)
+        printf("  %12.0f bytes/s", bytes / seconds);
+    if (units > 0)
+        printf("  %12.0f %s/s", units / seconds, unit);
+    printf("\n");
+}
+
+/**
+ * inserts, finds and erases random ids in edge sets of the sizes seen in de Bruijn graphs
+ */
+static void bench_edges() {
+    mt19937_64 random(1);
+    for (int set_size : {1, 2, 4, 8, 32}) {
+        vector<long> ids(static_cast<unsigned long>(set_size));
+        long operations = 0, found = 0;
+        Timer timer;
+        while (operations < EDGES_BENCH_OPERATIONS) {
+            Edges edges;
+            for (long &id : ids) {
+                id = static_cast<long>(random() % 1000000) - 500000;
+                edges.insert(id);
+            }
+            for (long id : ids)
+                found += edges.find(id);
+            for (long id : ids)
+                edges.erase(id);
+            operations += 3 * set_size;
+        }
+        double seconds = timer.seconds();
+        bench_sink = found;
+        report(("edges/" + to_string(set_size)).c_str(), seconds, 0, 0, 0, "ops", operations);
+    }
+}
+
+/**
+ * merges pairs of nodes that share a left neighbour and a prefix, or a right neighbour and a suffix, of random length
+ */
+static void bench_partial_merges(bool right_side) {
+    clear_graph();
+    mt19937_64 random(1);
+    vector<long> pair_ids;
+    for (long i = 0; i < PARTIAL_MERGE_BENCH_PAIRS; ++i) {
+        char *first_sequence = Node::graph->sequences.allocate(PARTIAL_MERGE_SEQUENCE_LEN);
+        char *second_sequence = Node::graph->sequences.allocate(PARTIAL_MERGE_SEQUENCE_LEN);
+        for (int j = 0; j < PARTIAL_MERGE_SEQUENCE_LEN; ++j)
+            first_sequence[j] = second_sequence[j] = "ACGT"[random() % 4];
+        int common_len = 1 + static_cast<int>(random() % (PARTIAL_MERGE_SEQUENCE_LEN - 1));
+        int mismatch = right_side ? PARTIAL_MERGE_SEQUENCE_LEN - 1 - common_len : common_len;
+        second_sequence[mismatch] = first_sequence[mismatch] == 'A' ? 'C' : 'A';
+        long neighbour_id = Node::add_node(first_sequence, 1);
+        long first_id = Node::add_node(first_sequence, PARTIAL_MERGE_SEQUENCE_LEN);
+        long second_id = Node::add_node(second_sequence, PARTIAL_MERGE_SEQUENCE_LEN);
+        if (right_side) {
+            Node::add_edge(first_id, '+', neighbour_id, '+');
+            Node::add_edge(second_id, '+', neighbour_id, '+');
+        } else {
+            Node::add_edge(neighbour_id, '+', first_id, '+');
+            Node::add_edge(neighbour_id, '+', second_id, '+');
+        }
+        pair_ids.push_back(first_id);
+    }
+    long merges = 0;
+    Timer timer;
+    for (long first_id : pair_ids) {
+        Node first_node(first_id), second_node(first_id + 1);
+        merges += (right_side ? second_node.partial_right_merge_to(first_node, true)
+                              : second_node.partial_left_merge_to(first_node, true)) != 0;
+    }
+    report(right_side ? "partial_merge/r" : "partial_merge/l", timer.seconds(), 0, 0, 0, "merges", merges);
+    clear_graph();
+}
+
+/**
+ * runs the phases of stark on the generated graph, timing each of them
+ */
+static void bench_phases(const char *gfa_file_name, long gfa_size) {
+    clear_graph();
+    Timer read_timer;
+    k = read_gfa(gfa_file_name, threads_count);
+    double read_seconds = read_timer.seconds();
+    report("read_gfa", read_seconds, Node::graph->nodes.size(), Node::graph->nodes.edges_count(), gfa_size);
+    compact_sequences();
+
+    long nodes = Node::graph->nodes.size(), edges = Node::graph->nodes.edges_count();
+    Timer unify_timer;
+    unify(k);
+    report("unify", unify_timer.seconds(), nodes, edges, 0);
+    compact_sequences();
+
+    nodes = Node::graph->nodes.size(), edges = Node::graph->nodes.edges_count();
+    Timer bluntify_timer;
+    bluntify();
+    report("bluntify", bluntify_timer.seconds(), nodes, edges, 0);
+
+    if (k % 2 == 0) {
+        nodes = Node::graph->nodes.size(), edges = Node::graph->nodes.edges_count();
+        Timer unify_1_timer;
+        unify(1);
+        report("unify(1)", unify_1_timer.seconds(), nodes, edges, 0);
+    }
+    compact_sequences();
+
+    nodes = Node::graph->nodes.size(), edges = Node::graph->nodes.edges_count();
+    Timer merge_timer;
+    merge_nodes(true);
+    report("merge_nodes", merge_timer.seconds(), nodes, edges, 0);
+
+    nodes = Node::graph->nodes.size(), edges = Node::graph->nodes.edges_count();
+    Timer freeze_timer;
+    FrozenGraph graph;
+    graph.freeze(threads_count);
+    report("freeze", freeze_timer.seconds(), nodes, edges, 0);
+
+    string output_file_name = string(gfa_file_name) + ".out";
+    Timer write_timer;
+    write_gfa(graph, output_file_name.c_str(), threads_count);
+    double write_seconds = write_timer.seconds();
+    FILE *output_file = fopen(output_file_name.c_str(), "r");
+    long output_size = 0;
+    if (output_file) {
+        fseek(output_file, 0, SEEK_END);
+        output_size = ftell(output_file);
+        fclose(output_file);
+    }
+    report("write_gfa", write_seconds, nodes, edges, output_size);
+    unlink(output_file_name.c_str());
+    clear_graph();
+}
+
+int main(int argc, char *argv[]) {
+    static struct option long_options[] =
+            {
+                    {"k",         required_argument, nullptr, 'k'},
+                    {"nodes",     required_argument, nullptr, 'n'},
+                    {"branching", required_argument, nullptr, 'b'},
+                    {"tips",      required_argument, nullptr, 'p'},
+                    {"bubbles",   required_argument, nullptr, 'u'},
+                    {"seed",      required_argument, nullptr, 's'},
+                    {"threads",   required_argument, nullptr, 't'},
+                    {"output",    required_argument, nullptr, 'o'},
+                    {nullptr, 0,                      nullptr, 0}
+            };
+    DbgGeneratorOptions options;
+    char *gfa_file_name = nullptr;
+    int option_index = 0, c;
+    bool need_help = false;
+    while ((c = getopt_long(argc, argv, "k:n:b:p:u:s:t:o:", long_options, &option_index)) >= 0)
+        switch (c) {
+            case 'k':
+                options.k = static_cast<int>(strtol(optarg, nullptr, 10));
+                break;
+            case 'n':
+                options.nodes = strtol(optarg, nullptr, 10);
+                break;
+            case 'b':
+                options.branching = strtod(optarg, nullptr);
+                break;
+            case 'p':
+                options.tips = strtod(optarg, nullptr);
+                break;
+            case 'u':
+                options.bubbles = strtod(optarg, nullptr);
+                break;
+            case 's':
+                options.seed = static_cast<unsigned>(strtoul(optarg, nullptr, 10));
+                break;
+            case 't':
+                threads_count = static_cast<int>(strtol(optarg, nullptr, 10));
+                break;
+            case 'o':
+                gfa_file_name = strdup(optarg);
+                break;
+            default:
+                need_help = true;
+                break;
+        }
+    if (need_help || options.k < 2 || options.nodes < 1 || threads_count < 1) {
+        printf("%s", help_str);
+        return 1;
+    }
+    logger = new Logger(Logger::OFF);
+    bool keep_gfa = gfa_file_name != nullptr;
+    if (!keep_gfa) {
+        gfa_file_name = strdup("/tmp/stark_bench_XXXXXX");
+        int fd = mkstemp(gfa_file_name);
+        if (fd < 0) {
+            printf("can not create a temporary file\n");
+            return 1;
+        }
+        close(fd);
+    }
+    Timer generate_timer;
+    long gfa_size = generate_dbg(options, gfa_file_name);
+    if (gfa_size < 0) {
+        printf("can not write file: %s\n", gfa_file_name);
+        return 1;
+    }
+    printf("k=%d nodes=%ld branching=%g tips=%g bubbles=%g seed=%u threads=%d\n", options.k, options.nodes,
+           options.branching, options.tips, options.bubbles, options.seed, threads_count);
+    report("generate", generate_timer.seconds(), 0, 0, gfa_size);
+    bench_edges();
+    bench_partial_merges(false);
+    bench_partial_merges(true);
+    bench_phases(gfa_file_name, gfa_size);
+    if (!keep_gfa)
+        unlink(gfa_file_name);
+    return 0;
+}
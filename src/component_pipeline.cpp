@@ -0,0 +1,171 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "component_pipeline.h"
+#include "gfa_writer.h"
+#include "graph_phases.h"
+#include "node.h"
+#include "utils/logger.h"
+#include "utils/union_find.h"
+
+using namespace std;
+
+#define COMPONENT_BIN_NODES         65536L
+#define COMPONENT_ARENA_CHUNK_SIZE  (1UL << 20) // bins are small, so their arenas take smaller chunks
+
+void ComponentPipeline::run(const function<void()> &pipeline, int threads_count) {
+    // bins of large components run in main_graph, the graph the threads started by their phases work on, so what
+    // main_graph holds is parked meanwhile
+    Graph parked_graph;
+    parked_graph.swap(Node::main_graph);
+    Graph *source = Node::graph == &Node::main_graph ? &parked_graph : Node::graph;
+    NodeTable &nodes = source->nodes;
+    long last_id = source->last_id;
+    // each component is rooted at its smallest id
+    vector<long> parents(static_cast<unsigned long>(last_id + 1));
+    for (long i = 0; i <= last_id; ++i)
+        parents[i] = i;
+    for (long i = 1; i <= last_id; ++i)
+        if (nodes.contains(i))
+            for (Edges *edges : {&nodes.left_edges(i), &nodes.right_edges(i)})
+                for (long neighbour_id : *edges)
+                    unite(parents, i, abs(neighbour_id));
+    vector<long> component_nodes(parents.size(), 0);
+    for (long i = 1; i <= last_id; ++i)
+        if (nodes.contains(i))
+            component_nodes[parents[i] = find_root(parents, i)]++;
+
+    // bins are numbered in order of their first nodes; the size of a root is then replaced by its bin
+    long bins_count = 0, components_count = 0, small_bin = -1, small_bin_nodes = 0;
+    vector<long> large_bins;
+    for (long i = 1; i <= last_id; ++i)
+        if (nodes.contains(i) && parents[i] == i) {
+            components_count++;
+            long component_size = component_nodes[i];
+            if (component_size >= COMPONENT_BIN_NODES) {
+                large_bins.push_back(bins_count);
+                component_nodes[i] = bins_count++;
+            } else {
+                if (small_bin == -1 || small_bin_nodes + component_size > COMPONENT_BIN_NODES) {
+                    small_bin = bins_count++;
+                    small_bin_nodes = 0;
+                }
+                small_bin_nodes += component_size;
+                component_nodes[i] = small_bin;
+            }
+        }
+    bins = vector<Bin>(static_cast<unsigned long>(bins_count));
+    for (long bin : large_bins)
+        bins[bin].large = true;
+    // parents are replaced by the ids the nodes get in their bins
+    for (long i = 1; i <= last_id; ++i)
+        if (nodes.contains(i)) {
+            vector<long> &bin_ids = bins[component_nodes[parents[i]]].ids;
+            bin_ids.push_back(i);
+            parents[i] = static_cast<long>(bin_ids.size());
+        }
+    vector<long>().swap(component_nodes);
+    LOG_DEBUG("running %ld components in %ld bins", components_count, bins_count);
+
+    // large bins come first, then the others by size
+    vector<long> order(static_cast<unsigned long>(bins_count));
+    for (long i = 0; i < bins_count; ++i)
+        order[i] = i;
+    stable_sort(order.begin(), order.end(), [&](long first_bin, long second_bin) {
+        if (bins[first_bin].large != bins[second_bin].large)
+            return bins[first_bin].large;
+        return bins[first_bin].ids.size() > bins[second_bin].ids.size();
+    });
+    // each source node gives up its edges once its bin has copied them, so the source shrinks as the bins are built
+    auto run_bin = [&](Bin &bin, Graph &graph, vector<long> &neighbour_ids) {
+        auto bin_size = static_cast<long>(bin.ids.size());
+        graph.nodes.reserve(bin_size);
+        for (long index = 0; index < bin_size; ++index) {
+            long id = bin.ids[index];
+            graph.nodes.add(index + 1, nodes.sequence(id), nodes.sequence_len(id));
+            for (bool right_side : {false, true}) {
+                neighbour_ids.clear();
+                for (long neighbour_id : right_side ? nodes.right_edges(id) : nodes.left_edges(id))
+                    neighbour_ids.push_back(neighbour_id < 0 ? -parents[-neighbour_id] : parents[neighbour_id]);
+                graph.nodes.assign_edges(index + 1, right_side, neighbour_ids.data(),
+                                         static_cast<int>(neighbour_ids.size()));
+                nodes.clear_edges(id, right_side);
+            }
+        }
+        graph.last_id = bin_size;
+        vector<long>().swap(bin.ids);
+        pipeline();
+        bin.graph.freeze(::threads_count);
+        bin.last_id = graph.last_id;
+        bin.sequences.absorb(graph.sequences);
+    };
+    // the bins run on threads of their own even for one thread, where Node::graph and threads_count start as
+    // main_graph and 1, so that the phases of the bins are not recorded in the profile of the caller. The large bins
+    // run one at a time with the phases on all threads, as the whole graph would; the other bins then share them.
+    auto large_bins_count = static_cast<long>(large_bins.size());
+    if (large_bins_count > 0)
+        thread([&]() {
+            ::threads_count = threads_count;
+            vector<long> neighbour_ids;
+            for (long j = 0; j < large_bins_count; ++j) {
+                run_bin(bins[order[j]], Node::main_graph, neighbour_ids);
+                Node::main_graph.nodes.clear();
+            }
+        }).join();
+    atomic<long> next_bin{large_bins_count};
+    auto run_bins = [&]() {
+        vector<long> neighbour_ids;
+        for (long j; (j = next_bin++) < bins_count;) {
+            Graph graph;
+            SequenceArena bin_sequences(COMPONENT_ARENA_CHUNK_SIZE);
+            graph.sequences.swap(bin_sequences);
+            Node::graph = &graph;
+            run_bin(bins[order[j]], graph, neighbour_ids);
+        }
+    };
+    vector<thread> threads;
+    for (int i = 0; i < threads_count; ++i)
+        threads.emplace_back(run_bins);
+    for (auto &thread : threads)
+        thread.join();
+    nodes.clear();
+    source->last_id = 0;
+    parked_graph.swap(Node::main_graph);
+}
+
+long ComponentPipeline::nodes_count() const {
+    long total_nodes = 0;
+    for (auto &bin : bins)
+        total_nodes += bin.graph.size();
+    return total_nodes;
+}
+
+long ComponentPipeline::edges_count() const {
+    long total_edges = 0;
+    for (auto &bin : bins)
+        total_edges += bin.graph.edges_count();
+    return total_edges;
+}
+
+long ComponentPipeline::ids_count() const {
+    long total_ids = 0;
+    for (auto &bin : bins)
+        total_ids += bin.last_id;
+    return total_ids;
+}
+
+bool ComponentPipeline::write(const char *file_name, int threads_count, long id_offset, bool append) const {
+    if (bins.empty())
+        return write_gfa(FrozenGraph(), file_name, threads_count, id_offset, append);
+    for (auto &bin : bins) {
+        if (!write_gfa(bin.graph, file_name, threads_count, id_offset, append))
+            return false;
+        id_offset += bin.last_id;
+        append = true;
+    }
+    return true;
+}
@@ -0,0 +1,58 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#include <functional>
+#include <vector>
+#include "frozen_graph.h"
+#include "sequence_arena.h"
+
+using namespace std;
+
+#ifndef STARK_COMPONENT_PIPELINE_H
+#define STARK_COMPONENT_PIPELINE_H
+
+/**
+ * Runs the phases on every weakly connected component of a graph on its own. No phase links two components, so the
+ * result is the graph the phases give on the whole graph, up to node ids, while whole pipelines run in parallel.
+ */
+class ComponentPipeline {
+public:
+    /**
+     * labels the components of Node::graph, packs the ones smaller than COMPONENT_BIN_NODES nodes into bins in id
+     * order, and runs pipeline() on a copy of each bin, renumbered from 1 in id order, with Node::graph set to the
+     * bin. Bins of one larger component run first, one at a time in main_graph, their phases on threads_count threads;
+     * then threads_count threads take the other bins one at a time, largest first, their phases on one thread each.
+     * Each bin is then kept frozen, and the nodes of Node::graph are cleared; its sequences and input file must stay.
+     */
+    void run(const function<void()> &pipeline, int threads_count);
+
+    long nodes_count() const;
+
+    long edges_count() const;
+
+    /**
+     * @return the node ids used by all bins together
+     */
+    long ids_count() const;
+
+    /**
+     * appends the bins to file_name in order of their first nodes, the node ids of each moved past those of the bins
+     * before it and id_offset; see write_gfa
+     * @param append whether to add the first bin to the end of the file too
+     */
+    bool write(const char *file_name, int threads_count, long id_offset = 0, bool append = false) const;
+
+private:
+    struct Bin {
+        vector<long> ids;
+        FrozenGraph graph;
+        SequenceArena sequences;
+        long last_id = 0;
+        bool large = false; // holds one component of COMPONENT_BIN_NODES nodes or more
+    };
+
+    vector<Bin> bins;
+};
+
+#endif //STARK_COMPONENT_PIPELINE_H
@@ -0,0 +1,128 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include "edges.h"
+
+Edges::Edges() = default;
+
+Edges::Edges(const Edges &another_edges) {
+    reserve(another_edges.edges_size);
+    edges_size = another_edges.edges_size;
+    memcpy(neighbour_ids(), another_edges.neighbour_ids(), edges_size * sizeof(long));
+}
+
+Edges::Edges(Edges &&another_edges) noexcept {
+    *this = move(another_edges);
+}
+
+Edges &Edges::operator=(const Edges &another_edges) {
+    if (this == &another_edges)
+        return *this;
+    edges_size = 0;
+    reserve(another_edges.edges_size);
+    edges_size = another_edges.edges_size;
+    memcpy(neighbour_ids(), another_edges.neighbour_ids(), edges_size * sizeof(long));
+    return *this;
+}
+
+Edges &Edges::operator=(Edges &&another_edges) noexcept {
+    if (this == &another_edges)
+        return *this;
+    if (edges_capacity > EDGES_INLINE_CAPACITY)
+        delete[] heap_ids;
+    edges_size = another_edges.edges_size;
+    edges_capacity = another_edges.edges_capacity;
+    if (edges_capacity > EDGES_INLINE_CAPACITY)
+        heap_ids = another_edges.heap_ids;
+    else
+        memcpy(inline_ids, another_edges.inline_ids, edges_size * sizeof(long));
+    another_edges.edges_size = 0;
+    another_edges.edges_capacity = EDGES_INLINE_CAPACITY;
+    return *this;
+}
+
+Edges::~Edges() {
+    if (edges_capacity > EDGES_INLINE_CAPACITY)
+        delete[] heap_ids;
+}
+
+void Edges::reserve(int new_capacity) {
+    if (new_capacity <= edges_capacity)
+        return;
+    new_capacity = max(new_capacity, edges_capacity * 2);
+    auto *new_ids = new long[new_capacity];
+    memcpy(new_ids, neighbour_ids(), edges_size * sizeof(long));
+    if (edges_capacity > EDGES_INLINE_CAPACITY)
+        delete[] heap_ids;
+    heap_ids = new_ids;
+    edges_capacity = new_capacity;
+}
+
+void Edges::erase(long id) {
+    long *ids = neighbour_ids();
+    long *position = lower_bound(ids, ids + edges_size, id);
+    if (position == ids + edges_size || *position != id)
+        return;
+    memmove(position, position + 1, (ids + edges_size - position - 1) * sizeof(long));
+    edges_size--;
+}
+
+void Edges::insert(long id) {
+    long *ids = neighbour_ids();
+    long *position = lower_bound(ids, ids + edges_size, id);
+    if (position != ids + edges_size && *position == id)
+        return;
+    long index = position - ids;
+    reserve(edges_size + 1);
+    ids = neighbour_ids();
+    memmove(ids + index + 1, ids + index, (edges_size - index) * sizeof(long));
+    ids[index] = id;
+    edges_size++;
+}
+
+void Edges::assign(const long *ids, int count) {
+    edges_size = 0;
+    reserve(count);
+    edges_size = count;
+    memcpy(neighbour_ids(), ids, count * sizeof(long));
+}
+
+void Edges::clear() {
+    edges_size = 0;
+}
+
+void Edges::merge_with(const Edges &another_edges) {
+    if (another_edges.edges_size == 0)
+        return;
+    long merged_ids[EDGES_INLINE_CAPACITY * 2];
+    int merged_capacity = edges_size + another_edges.edges_size;
+    long *merged = merged_capacity <= EDGES_INLINE_CAPACITY * 2 ? merged_ids : new long[merged_capacity];
+    const long *ids = neighbour_ids(), *another_ids = another_edges.neighbour_ids();
+    long *merged_end = set_union(ids, ids + edges_size, another_ids, another_ids + another_edges.edges_size, merged);
+    auto merged_size = static_cast<int>(merged_end - merged);
+    reserve(merged_size);
+    memcpy(neighbour_ids(), merged, merged_size * sizeof(long));
+    edges_size = merged_size;
+    if (merged != merged_ids)
+        delete[] merged;
+}
+
+bool Edges::find(long id) {
+    const long *ids = neighbour_ids();
+    if (edges_size <= EDGES_INLINE_CAPACITY) {
+        for (int i = 0; i < edges_size; ++i)
+            if (ids[i] == id)
+                return true;
+        return false;
+    }
+    return binary_search(ids, ids + edges_size, id);
+}
+
+bool Edges::operator==(const Edges &another_edges) const {
+    return edges_size == another_edges.edges_size &&
+           memcmp(neighbour_ids(), another_edges.neighbour_ids(), edges_size * sizeof(long)) == 0;
+}
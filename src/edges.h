@@ -0,0 +1,146 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+using namespace std;
+
+#ifndef STARK_EDGES_H
+#define STARK_EDGES_H
+
+#define EDGES_INLINE_CAPACITY       4
+
+
+/**
+ * The sorted set of signed neighbour ids on one side of a node. Up to EDGES_INLINE_CAPACITY ids are stored inside
+ * the object, larger sets spill to the heap.
+ */
+class Edges {
+private:
+    class EdgesIterator {
+    private:
+        Edges *edges;
+        int index;
+    public:
+        EdgesIterator() = delete;
+
+        explicit EdgesIterator(Edges *edges, int index);
+
+        bool operator!=(const EdgesIterator &edgesIterator);
+
+        void operator++();
+
+        long operator*();
+    };
+
+    int edges_size = 0;
+    int edges_capacity = EDGES_INLINE_CAPACITY;
+    union {
+        long inline_ids[EDGES_INLINE_CAPACITY];
+        long *heap_ids;
+    };
+
+    long *neighbour_ids();
+
+    const long *neighbour_ids() const;
+
+    void reserve(int new_capacity);
+
+public:
+    Edges();
+
+    Edges(const Edges &another_edges);
+
+    Edges(Edges &&another_edges) noexcept;
+
+    Edges &operator=(const Edges &another_edges);
+
+    Edges &operator=(Edges &&another_edges) noexcept;
+
+    ~Edges();
+
+    bool empty();
+
+    long size();
+
+    void erase(long id);
+
+    void insert(long id);
+
+    /**
+     * replaces the set with count ids, which must be sorted and distinct
+     */
+    void assign(const long *ids, int count);
+
+    void clear();
+
+    void merge_with(const Edges &another_edges);
+
+    bool find(long id);
+
+    long front();
+
+    long back();
+
+    long get(int index);
+
+    EdgesIterator begin();
+
+    EdgesIterator end();
+
+    bool operator==(const Edges &another_edges) const;
+};
+
+inline long *Edges::neighbour_ids() {
+    return edges_capacity > EDGES_INLINE_CAPACITY ? heap_ids : inline_ids;
+}
+
+inline const long *Edges::neighbour_ids() const {
+    return edges_capacity > EDGES_INLINE_CAPACITY ? heap_ids : inline_ids;
+}
+
+inline bool Edges::empty() {
+    return edges_size == 0;
+}
+
+inline long Edges::size() {
+    return edges_size;
+}
+
+inline long Edges::front() {
+    return neighbour_ids()[0];
+}
+
+inline long Edges::back() {
+    return neighbour_ids()[edges_size - 1];
+}
+
+inline long Edges::get(int index) {
+    return neighbour_ids()[index];
+}
+
+inline Edges::EdgesIterator::EdgesIterator(Edges *edges, int index) : edges(edges) {
+    this->index = static_cast<int>((index == -1) ? edges->size() : index);
+}
+
+inline bool Edges::EdgesIterator::operator!=(const Edges::EdgesIterator &edgesIterator) {
+    return (edges != edgesIterator.edges) || (index != edgesIterator.index);
+}
+
+inline void Edges::EdgesIterator::operator++() {
+    index++;
+}
+
+inline long Edges::EdgesIterator::operator*() {
+    return edges->get(index);
+}
+
+inline Edges::EdgesIterator Edges::begin() {
+    return Edges::EdgesIterator(this, 0);
+}
+
+inline Edges::EdgesIterator Edges::end() {
+    return Edges::EdgesIterator(this, -1);
+}
+
+
+#endif //STARK_EDGES_H
@@ -0,0 +1,98 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#include "frozen_graph.h"
+#include "node.h"
+#include "utils/parallel.h"
+
+static int varint_len(uint64_t value) {
+    int len = 1;
+    for (; value >= 0x80; value >>= 7)
+        len++;
+    return len;
+}
+
+static uint64_t zigzag(long value) {
+    return static_cast<uint64_t>(value) << 1 ^ static_cast<uint64_t>(value >> 63);
+}
+
+/**
+ * @return the bytes taken by the neighbours on one side, each stored as a difference to the previous one
+ */
+static long encoded_len(long id, Edges &edges) {
+    long len = 0, previous_id = id;
+    for (long neighbour_id : edges) {
+        len += varint_len(zigzag(neighbour_id - previous_id));
+        previous_id = neighbour_id;
+    }
+    return len;
+}
+
+static uint8_t *encode(uint8_t *out, long id, Edges &edges) {
+    long previous_id = id;
+    for (long neighbour_id : edges) {
+        uint64_t value = zigzag(neighbour_id - previous_id);
+        for (; value >= 0x80; value >>= 7)
+            *out++ = static_cast<uint8_t>(value | 0x80);
+        *out++ = static_cast<uint8_t>(value);
+        previous_id = neighbour_id;
+    }
+    return out;
+}
+
+void FrozenGraph::freeze(int threads_count) {
+    // the graph of this thread, which the helper threads do not share
+    NodeTable &nodes = Node::graph->nodes;
+    long last_id = Node::graph->last_id;
+    if (threads_count < 1)
+        threads_count = 1;
+    // first count the live nodes and their encoded bytes in each range, then fill the ranges at their offsets
+    vector<long> range_nodes(static_cast<unsigned long>(threads_count + 1), 0);
+    vector<long> range_bytes(static_cast<unsigned long>(threads_count + 1), 0);
+    parallel_ranges(1, last_id + 1, threads_count, [&](int thread_index, long range_begin, long range_end) {
+        for (long i = range_begin; i < range_end; ++i)
+            if (nodes.contains(i)) {
+                range_nodes[thread_index + 1]++;
+                range_bytes[thread_index + 1] +=
+                        encoded_len(i, nodes.left_edges(i)) + encoded_len(i, nodes.right_edges(i));
+            }
+    });
+    for (int i = 0; i < threads_count; ++i) {
+        range_nodes[i + 1] += range_nodes[i];
+        range_bytes[i + 1] += range_bytes[i];
+    }
+    auto nodes_count = static_cast<unsigned long>(range_nodes.back());
+    ids.resize(nodes_count);
+    sequences.resize(nodes_count);
+    sequence_lens.resize(nodes_count);
+    left_degrees.resize(nodes_count);
+    right_degrees.resize(nodes_count);
+    neighbour_offsets.resize(nodes_count + 1);
+    neighbours.resize(static_cast<unsigned long>(range_bytes.back()));
+    neighbour_offsets[nodes_count] = range_bytes.back();
+    parallel_ranges(1, last_id + 1, threads_count, [&](int thread_index, long range_begin, long range_end) {
+        long index = range_nodes[thread_index];
+        uint8_t *out = neighbours.data() + range_bytes[thread_index];
+        for (long i = range_begin; i < range_end; ++i) {
+            if (!nodes.contains(i))
+                continue;
+            Edges &left_edges = nodes.left_edges(i), &right_edges = nodes.right_edges(i);
+            ids[index] = i;
+            sequences[index] = nodes.sequence(i);
+            sequence_lens[index] = nodes.sequence_len(i);
+            left_degrees[index] = static_cast<int>(left_edges.size());
+            right_degrees[index] = static_cast<int>(right_edges.size());
+            neighbour_offsets[index] = out - neighbours.data();
+            out = encode(encode(out, i, left_edges), i, right_edges);
+            index++;
+        }
+    });
+}
+
+long FrozenGraph::edges_count() const {
+    long total_degrees = 0;
+    for (unsigned long i = 0; i < ids.size(); ++i)
+        total_degrees += left_degrees[i] + right_degrees[i];
+    return total_degrees / 2;
+}
@@ -0,0 +1,117 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#include <cstdint>
+#include <vector>
+#include "sequence_ref.h"
+
+using namespace std;
+
+#ifndef STARK_FROZEN_GRAPH_H
+#define STARK_FROZEN_GRAPH_H
+
+/**
+ * A read-only copy of Node::graph in compressed sparse row form, for passes that only read the graph. Live nodes are
+ * numbered by index in id order. The neighbours of each node are one byte run: left then right neighbours, each
+ * signed neighbour id stored as the zigzag varint of its difference to the previous one (to the node id for the first
+ * of a side), so the sign keeps the side of the neighbour. It must be frozen again after the graph changes.
+ */
+class FrozenGraph {
+public:
+    /**
+     * copies Node::graph, on threads_count threads
+     */
+    void freeze(int threads_count = 1);
+
+    long size() const;
+
+    long edges_count() const;
+
+    long id(long index) const;
+
+    SequenceRef sequence(long index) const;
+
+    int sequence_len(long index) const;
+
+    int left_degree(long index) const;
+
+    int right_degree(long index) const;
+
+    /**
+     * calls function(neighbour_id) for the signed neighbour ids on the left or right side of the node at index, in
+     * increasing order
+     */
+    template<typename Function>
+    void for_each_neighbour(long index, bool right_side, Function function) const;
+
+private:
+    static const uint8_t *skip_varints(const uint8_t *data, int count);
+
+    static const uint8_t *read_varint(const uint8_t *data, uint64_t &value);
+
+    vector<long> ids;
+    vector<SequenceRef> sequences;
+    vector<int> sequence_lens;
+    vector<int> left_degrees;
+    vector<int> right_degrees;
+    vector<long> neighbour_offsets;
+    vector<uint8_t> neighbours;
+};
+
+inline long FrozenGraph::size() const {
+    return static_cast<long>(ids.size());
+}
+
+inline long FrozenGraph::id(long index) const {
+    return ids[index];
+}
+
+inline SequenceRef FrozenGraph::sequence(long index) const {
+    return sequences[index];
+}
+
+inline int FrozenGraph::sequence_len(long index) const {
+    return sequence_lens[index];
+}
+
+inline int FrozenGraph::left_degree(long index) const {
+    return left_degrees[index];
+}
+
+inline int FrozenGraph::right_degree(long index) const {
+    return right_degrees[index];
+}
+
+inline const uint8_t *FrozenGraph::read_varint(const uint8_t *data, uint64_t &value) {
+    value = 0;
+    for (int shift = 0;; shift += 7) {
+        uint8_t byte = *data++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (byte < 0x80)
+            return data;
+    }
+}
+
+inline const uint8_t *FrozenGraph::skip_varints(const uint8_t *data, int count) {
+    while (count > 0)
+        if (*data++ < 0x80)
+            count--;
+    return data;
+}
+
+template<typename Function>
+void FrozenGraph::for_each_neighbour(long index, bool right_side, Function function) const {
+    const uint8_t *data = neighbours.data() + neighbour_offsets[index];
+    if (right_side)
+        data = skip_varints(data, left_degrees[index]);
+    long neighbour_id = ids[index];
+    for (int i = right_side ? right_degrees[index] : left_degrees[index]; i > 0; --i) {
+        uint64_t zigzag;
+        data = read_varint(data, zigzag);
+        neighbour_id += static_cast<long>(zigzag >> 1) ^ -static_cast<long>(zigzag & 1);
+        function(neighbour_id);
+    }
+}
+
+#endif //STARK_FROZEN_GRAPH_H
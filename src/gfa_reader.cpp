@@ -0,0 +1,607 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <unistd.h>
+#include "gfa_reader.h"
+#include "node.h"
+#include "sequence_arena.h"
+#include "utils/gzip.h"
+#include "utils/logger.h"
+#include "utils/mapped_file.h"
+#include "utils/parallel.h"
+#include "utils/sequence_compare.h"
+#include "utils/union_find.h"
+
+using namespace std;
+
+#define MAX_FIELDS                  10
+#define PARTITION_WINDOW_SIZE       (1L << 22)
+#define PARTITION_NODE_BYTES        320L // about the memory a node takes in the phases, edges and bookkeeping included
+#define NUMERIC_NAMES_FACTOR        4L
+
+extern Logger *logger;
+
+struct GfaField {
+    char *begin;
+    long len;
+};
+
+struct GfaSegment {
+    GfaField name;
+    GfaField sequence;
+    char *line;
+};
+
+struct GfaLink {
+    GfaField from_name;
+    GfaField to_name;
+    char from_sign;
+    char to_sign;
+    int match;
+    char *line;
+};
+
+struct GfaChunk {
+    vector<GfaSegment> segments;
+    vector<GfaLink> links;
+    vector<GfaField> discarded_lines;
+};
+
+struct ResolvedLink {
+    long from_id;
+    long to_id;
+};
+
+/**
+ * a segment name inside the input file, or a copy of it
+ */
+struct GfaName {
+    const char *begin;
+    long len;
+
+    bool operator==(const GfaName &another_name) const {
+        return len == another_name.len && memcmp(begin, another_name.begin, static_cast<size_t>(len)) == 0;
+    }
+};
+
+struct GfaNameHash {
+    size_t operator()(const GfaName &name) const {
+        size_t hash = 14695981039346656037UL; // FNV-1a
+        for (long i = 0; i < name.len; ++i)
+            hash = (hash ^ static_cast<unsigned char>(name.begin[i])) * 1099511628211UL;
+        return hash;
+    }
+};
+
+/**
+ * @return the number a segment name is in decimal without leading zeros, as BCALM and cuttlefish write them, or -1
+ */
+static long name_number(const GfaField &name) {
+    if (name.len == 0 || name.len > 18 || (name.begin[0] == '0' && name.len > 1))
+        return -1;
+    long number = 0;
+    for (long i = 0; i < name.len; ++i) {
+        if (name.begin[i] < '0' || name.begin[i] > '9')
+            return -1;
+        number = number * 10 + (name.begin[i] - '0');
+    }
+    return number;
+}
+
+/**
+ * Maps segment names to node ids. Names that are numbers below numbers_end index a flat array; other names are
+ * hashed as they are in the input file, which must outlive the map.
+ */
+class SegmentNames {
+public:
+    explicit SegmentNames(long numbers_end) : numbered_ids(static_cast<size_t>(numbers_end), 0) {}
+
+    /**
+     * maps name to id, replacing an earlier segment with the same name
+     */
+    void add(const GfaField &name, long id) {
+        long number = numbered_index(name);
+        if (number >= 0)
+            numbered_ids[number] = id;
+        else
+            named_ids[GfaName{name.begin, name.len}] = id;
+    }
+
+    /**
+     * @return the node id of name, or 0 if no segment has it
+     */
+    long find(const GfaField &name) const {
+        long number = numbered_index(name);
+        if (number >= 0)
+            return numbered_ids[number];
+        auto named_id = named_ids.find(GfaName{name.begin, name.len});
+        return named_id != named_ids.end() ? named_id->second : 0;
+    }
+
+private:
+    /**
+     * @return the index of name in numbered_ids, or -1 if it has none
+     */
+    long numbered_index(const GfaField &name) const {
+        long number = name_number(name);
+        return number < static_cast<long>(numbered_ids.size()) ? number : -1;
+    }
+
+    vector<long> numbered_ids;
+    unordered_map<GfaName, long, GfaNameHash> named_ids;
+};
+
+/**
+ * calls function(id, right_side, neighbour_id) for the two sides a resolved link joins, as Node::add_edge adds them
+ */
+template<typename Function>
+static void for_each_link_side(const GfaLink &link, const ResolvedLink &resolved_link, Function function) {
+    function(resolved_link.from_id, link.from_sign == '+',
+             link.to_sign == '-' ? resolved_link.to_id : -1 * resolved_link.to_id);
+    function(resolved_link.to_id, link.to_sign != '+',
+             link.from_sign == '+' ? resolved_link.from_id : -1 * resolved_link.from_id);
+}
+
+/**
+ * splits [line, line_end) at tabs into at most max_fields fields, the last field keeps the rest of the line
+ */
+static int split_fields(char *line, char *line_end, GfaField *fields, int max_fields) {
+    int fields_count = 0;
+    while (true) {
+        auto *tab = static_cast<char *>(fields_count + 1 < max_fields ? memchr(line, '\t', line_end - line) : nullptr);
+        char *field_end = tab ? tab : line_end;
+        fields[fields_count++] = {line, field_end - line};
+        if (!tab)
+            return fields_count;
+        line = tab + 1;
+    }
+}
+
+static bool parse_line(char *line, char *line_end, GfaChunk &chunk) {
+    GfaField fields[MAX_FIELDS];
+    int fields_count = split_fields(line, line_end, fields, MAX_FIELDS);
+    switch (line[0]) {
+        case 'H':
+            return fields_count > 1 && fields[1].len > 5 && memcmp(fields[1].begin, "VN", 2) == 0;
+        case 'S':
+            if (fields_count < 3)
+                return false;
+            if (isdigit(fields[2].begin[0])) { // GFA2: S id length sequence
+                if (fields_count < 4)
+                    return false;
+                chunk.segments.push_back({fields[1], fields[3], line});
+            } else
+                chunk.segments.push_back({fields[1], fields[2], line});
+            return true;
+        case 'L':
+            if (fields_count < 6 || fields[2].len != 1 || fields[4].len != 1)
+                return false;
+            chunk.links.push_back({fields[1], fields[3], fields[2].begin[0], fields[4].begin[0],
+                                   static_cast<int>(strtol(fields[5].begin, nullptr, 10)), line});
+            return true;
+        case 'E': // E id from_id± to_id± from_begin from_end to_begin to_end alignment
+            if (fields_count < 6 || fields[2].len < 2 || fields[3].len < 2)
+                return false;
+            chunk.links.push_back({{fields[2].begin, fields[2].len - 1}, {fields[3].begin, fields[3].len - 1},
+                                   fields[2].begin[fields[2].len - 1], fields[3].begin[fields[3].len - 1],
+                                   static_cast<int>(strtol(fields[5].begin, nullptr, 10) -
+                                                    strtol(fields[4].begin, nullptr, 10)), line});
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void parse_chunk(char *begin, char *end, GfaChunk &chunk) {
+    for (char *line = begin, *line_end; line < end; line = line_end + 1) {
+        line_end = static_cast<char *>(memchr(line, '\n', end - line));
+        if (!line_end)
+            line_end = end;
+        char *content_end = (line_end > line && line_end[-1] == '\r') ? line_end - 1 : line_end;
+        if (content_end == line)
+            continue;
+        if (!parse_line(line, content_end, chunk))
+            chunk.discarded_lines.push_back({line, content_end - line});
+    }
+}
+
+/**
+ * @return parts + 1 boundaries that split [begin, end) into parts of about the same size, at line starts
+ */
+static vector<char *> split_lines(char *begin, char *end, int parts) {
+    vector<char *> boundaries(static_cast<size_t>(parts + 1), end);
+    boundaries[0] = begin;
+    for (int i = 1; i < parts; ++i) {
+        char *boundary = begin + (end - begin) * i / parts;
+        if (boundary > boundaries[i - 1]) { // move to the start of the next line
+            auto *newline = static_cast<char *>(memchr(boundary - 1, '\n', end - boundary + 1));
+            boundaries[i] = newline ? newline + 1 : end;
+        } else
+            boundaries[i] = boundaries[i - 1];
+    }
+    return boundaries;
+}
+
+int read_gfa(const char *file_name, int threads_count, long max_node_ids) {
+    int k = -1;
+    long last_id_before = Node::graph->last_id;
+    LOG_DEBUG("reading gfa file: %s", file_name);
+    MappedFile *&input_file = Node::graph->input_file;
+    input_file = new MappedFile(file_name, COMPARE_BLOCK_SIZE, threads_count);
+    if (!input_file->is_open()) {
+        LOG_FATAL("can not open or decompress file: %s", file_name);
+        return -2;
+    }
+    char *file_begin = input_file->data(), *file_end = file_begin + input_file->size();
+    if (threads_count < 1)
+        threads_count = 1;
+
+    vector<char *> boundaries = split_lines(file_begin, file_end, threads_count);
+    vector<GfaChunk> chunks(static_cast<size_t>(threads_count));
+    run_on_threads(threads_count, [&](int i) { parse_chunk(boundaries[i], boundaries[i + 1], chunks[i]); });
+    LOG_DEBUG("gfa file parsed");
+
+    // segments get their ids in file order; numeric names index a flat array up to the largest one that is not far
+    // beyond the number of segments
+    long segments_count = 0;
+    for (auto &chunk : chunks)
+        segments_count += static_cast<long>(chunk.segments.size());
+    vector<long> max_numbers(chunks.size(), -1);
+    run_on_threads(threads_count, [&](int i) {
+        for (auto &segment : chunks[i].segments) {
+            long number = name_number(segment.name);
+            if (number < NUMERIC_NAMES_FACTOR * segments_count)
+                max_numbers[i] = max(max_numbers[i], number);
+        }
+    });
+    SegmentNames segment_names(*max_element(max_numbers.begin(), max_numbers.end()) + 1);
+    for (auto &chunk : chunks) {
+        for (auto &discarded_line : chunk.discarded_lines)
+            LOG_WARN("line not supported: %.*s", static_cast<int>(discarded_line.len), discarded_line.begin);
+        for (auto &segment : chunk.segments) {
+            if (max_node_ids != -1 && Node::graph->last_id >= max_node_ids)
+                break;
+            segment_names.add(segment.name,
+                              Node::add_node(segment.sequence.begin, static_cast<int>(segment.sequence.len)));
+        }
+        chunk.segments = vector<GfaSegment>();
+    }
+
+    // the neighbours of every side of the new nodes are gathered in a slice of one array: the sides are counted while
+    // the links are resolved, then filled from the ends of their slices, so that side_ends[side] ends up at the start
+    // of its slice. Several threads share the counts through atomic updates
+    long first_id = last_id_before + 1, sides_count = 2 * (Node::graph->last_id - last_id_before);
+    vector<long> side_ends(static_cast<size_t>(sides_count + 1), 0);
+    auto side_index = [&](long id, bool right_side) {
+        return 2 * (id - first_id) + right_side;
+    };
+    vector<vector<ResolvedLink>> resolved_links(chunks.size());
+    run_on_threads(threads_count, [&](int i) {
+        resolved_links[i].reserve(chunks[i].links.size());
+        for (auto &link : chunks[i].links) {
+            long from_id = segment_names.find(link.from_name), to_id = segment_names.find(link.to_name);
+            if (from_id == 0 || to_id == 0) {
+                resolved_links[i].push_back({0, 0});
+                continue;
+            }
+            resolved_links[i].push_back({from_id, to_id});
+            for_each_link_side(link, resolved_links[i].back(), [&](long id, bool right_side, long) {
+                long &side_end = side_ends[side_index(id, right_side)];
+                if (threads_count > 1)
+                    __atomic_fetch_add(&side_end, 1, __ATOMIC_RELAXED);
+                else
+                    side_end++;
+            });
+        }
+    });
+    for (auto &chunk : chunks)
+        for (auto &link : chunk.links) {
+            if (k == -1)
+                k = link.match + 1;
+            if (k != link.match + 1)
+                LOG_ERROR("Error! different k's: %d - %d", k, link.match + 1);
+        }
+    if (max_node_ids == -1)
+        for (unsigned long i = 0; i < chunks.size(); ++i)
+            for (unsigned long j = 0; j < chunks[i].links.size(); ++j)
+                if (resolved_links[i][j].from_id == 0) {
+                    GfaLink &link = chunks[i].links[j];
+                    LOG_WARN("Undefined node: %.*s -> %.*s!", static_cast<int>(link.from_name.len),
+                             link.from_name.begin, static_cast<int>(link.to_name.len), link.to_name.begin);
+                }
+
+    for (long side = 1; side <= sides_count; ++side)
+        side_ends[side] += side_ends[side - 1];
+    vector<long> neighbour_ids(static_cast<size_t>(side_ends[sides_count]));
+    run_on_threads(threads_count, [&](int i) {
+        for (unsigned long j = 0; j < chunks[i].links.size(); ++j)
+            if (resolved_links[i][j].from_id != 0)
+                for_each_link_side(chunks[i].links[j], resolved_links[i][j],
+                                   [&](long id, bool right_side, long neighbour_id) {
+                                       long &side_end = side_ends[side_index(id, right_side)];
+                                       neighbour_ids[threads_count > 1 ? __atomic_sub_fetch(&side_end, 1,
+                                                                                            __ATOMIC_RELAXED)
+                                                                       : --side_end] = neighbour_id;
+                                   });
+    });
+    parallel_for(0, sides_count, threads_count, [&](long side) {
+        long *side_begin = neighbour_ids.data() + side_ends[side];
+        long *side_end = neighbour_ids.data() + side_ends[side + 1];
+        if (side_begin == side_end)
+            return;
+        sort(side_begin, side_end);
+        side_end = unique(side_begin, side_end);
+        Node::graph->nodes.assign_edges(first_id + side / 2, side % 2 == 1, side_begin,
+                                        static_cast<int>(side_end - side_begin));
+    });
+    LOG_DEBUG("read completed!");
+    return k;
+}
+
+/**
+ * Gives the text of a GFA file in windows of whole lines, about PARTITION_WINDOW_SIZE bytes per thread each. A gzip
+ * file is decompressed one window at a time, so that its text is never held in memory as a whole.
+ */
+class GfaWindows {
+public:
+    GfaWindows(const MappedFile &file, int threads_count) : file(file),
+                                                            window_size(PARTITION_WINDOW_SIZE * threads_count) {
+        if (is_gzip(file.data(), file.size()))
+            reader = new GzipReader(file.data(), file.size(), threads_count);
+        rewind();
+    }
+
+    GfaWindows(const GfaWindows &) = delete;
+
+    GfaWindows &operator=(const GfaWindows &) = delete;
+
+    ~GfaWindows() {
+        delete reader;
+    }
+
+    void rewind() {
+        next_window = file.data();
+        if (reader)
+            reader->rewind();
+        buffered_size = window_end_offset = 0;
+    }
+
+    /**
+     * @return false after the last window, or if the file turns out not to be valid gzip
+     */
+    bool next(char *&window_begin, char *&window_end) {
+        char *file_end = file.data() + file.size();
+        if (!reader) {
+            window_begin = next_window;
+            window_end = window_begin + min(window_size, file_end - window_begin);
+            if (window_end < file_end) {
+                auto *newline = static_cast<char *>(memchr(window_end - 1, '\n', file_end - window_end + 1));
+                window_end = newline ? newline + 1 : file_end;
+            }
+            next_window = window_end;
+            return window_begin < window_end;
+        }
+        // the buffer holds the rest of the last line decompressed for the window before, which is moved to its start
+        buffered_size -= window_end_offset;
+        if (buffered_size > 0)
+            memmove(buffer.data(), buffer.data() + window_end_offset, buffered_size);
+        window_end_offset = 0;
+        for (long target_size = window_size; window_end_offset == 0; target_size *= 2) { // doubled for longer lines
+            if (buffer.size() < target_size + BGZF_MAX_BLOCK_SIZE + 1UL)
+                buffer.resize(target_size + BGZF_MAX_BLOCK_SIZE + 1UL);
+            while (!reader->at_end() && buffered_size < static_cast<size_t>(target_size))
+                buffered_size += reader->read(buffer.data() + buffered_size, buffer.size() - 1 - buffered_size);
+            if (reader->failed())
+                return false;
+            if (reader->at_end()) {
+                window_end_offset = buffered_size;
+                break;
+            }
+            auto *newline = static_cast<char *>(memrchr(buffer.data(), '\n', buffered_size));
+            if (newline)
+                window_end_offset = newline + 1 - buffer.data();
+        }
+        buffer[buffered_size] = 0;
+        window_begin = buffer.data();
+        window_end = window_begin + window_end_offset;
+        return window_begin < window_end;
+    }
+
+    bool failed() const {
+        return reader && reader->failed();
+    }
+
+private:
+    const MappedFile &file;
+    long window_size;
+    GzipReader *reader = nullptr;
+    char *next_window = nullptr;
+    vector<char> buffer;
+    size_t buffered_size = 0, window_end_offset = 0;
+};
+
+/**
+ * parses the windows of a file from the first one, each window on threads_count threads, and calls
+ * function(chunk, window_end) for the parsed chunks in file order
+ */
+template<typename Function>
+static void for_each_chunk(GfaWindows &windows, int threads_count, Function function) {
+    vector<GfaChunk> chunks(static_cast<size_t>(threads_count));
+    windows.rewind();
+    for (char *window_begin, *window_end; windows.next(window_begin, window_end);) {
+        vector<char *> boundaries = split_lines(window_begin, window_end, threads_count);
+        run_on_threads(threads_count, [&](int i) {
+            chunks[i].segments.clear();
+            chunks[i].links.clear();
+            chunks[i].discarded_lines.clear();
+            parse_chunk(boundaries[i], boundaries[i + 1], chunks[i]);
+        });
+        for (auto &chunk : chunks)
+            function(chunk, window_end);
+    }
+}
+
+/**
+ * @return the length of the line starting at line, with its newline
+ */
+static long line_len(const char *line, const char *end) {
+    auto *newline = static_cast<const char *>(memchr(line, '\n', static_cast<size_t>(end - line)));
+    return (newline ? newline + 1 : end) - line;
+}
+
+bool partition_gfa(const char *file_name, size_t memory_budget, int &k, vector<string> &part_file_names,
+                   int threads_count) {
+    LOG_DEBUG("partitioning gfa file: %s", file_name);
+    k = -1;
+    part_file_names.clear();
+    MappedFile file(file_name, 1, threads_count, false);
+    if (!file.is_open()) {
+        LOG_FATAL("can not open or decompress file: %s", file_name);
+        return false;
+    }
+    if (threads_count < 1)
+        threads_count = 1;
+    GfaWindows windows(file, threads_count);
+
+    // segments are numbered in order of their first definition; weights are their estimated bytes in memory. The
+    // names are copied, as a window of a gzip file does not outlive its pass.
+    SequenceArena names;
+    unordered_map<GfaName, long, GfaNameHash> segment_indices;
+    vector<long> weights;
+    for_each_chunk(windows, threads_count, [&](GfaChunk &chunk, char *window_end) {
+        for (auto &segment : chunk.segments) {
+            auto segment_index = segment_indices.find(GfaName{segment.name.begin, segment.name.len});
+            if (segment_index == segment_indices.end()) {
+                const char *name = names.append(segment.name.begin, static_cast<size_t>(segment.name.len));
+                segment_index = segment_indices.emplace(GfaName{name, segment.name.len},
+                                                        static_cast<long>(weights.size())).first;
+                weights.push_back(PARTITION_NODE_BYTES);
+            }
+            weights[segment_index->second] += line_len(segment.line, window_end);
+        }
+    });
+    if (windows.failed()) {
+        LOG_FATAL("can not open or decompress file: %s", file_name);
+        return false;
+    }
+
+    // each component is rooted at its first segment; links count for the segment they start from
+    vector<long> parents(weights.size());
+    for (unsigned long i = 0; i < parents.size(); ++i)
+        parents[i] = static_cast<long>(i);
+    for_each_chunk(windows, threads_count, [&](GfaChunk &chunk, char *window_end) {
+        for (auto &link : chunk.links) {
+            if (k == -1)
+                k = link.match + 1;
+            auto from_segment = segment_indices.find(GfaName{link.from_name.begin, link.from_name.len});
+            auto to_segment = segment_indices.find(GfaName{link.to_name.begin, link.to_name.len});
+            if (from_segment == segment_indices.end() || to_segment == segment_indices.end())
+                continue;
+            weights[from_segment->second] += line_len(link.line, window_end);
+            unite(parents, from_segment->second, to_segment->second);
+        }
+    });
+
+    // components are packed into parts in order of their roots, a new part starting when the budget is reached; the
+    // weight of a root is then replaced by its part
+    for (unsigned long i = 0; i < parents.size(); ++i) {
+        parents[i] = find_root(parents, static_cast<long>(i));
+        if (parents[i] != static_cast<long>(i))
+            weights[parents[i]] += weights[i];
+    }
+    long parts_count = 0;
+    size_t part_weight = 0;
+    for (unsigned long i = 0; i < parents.size(); ++i)
+        if (parents[i] == static_cast<long>(i)) {
+            auto weight = static_cast<size_t>(weights[i]);
+            if (weight > memory_budget)
+                LOG_WARN("a component of about %lu bytes does not fit in the memory budget", weight);
+            if (parts_count == 0 || (part_weight > 0 && part_weight + weight > memory_budget)) {
+                parts_count++;
+                part_weight = 0;
+            }
+            part_weight += weight;
+            weights[i] = parts_count - 1;
+        }
+    if (parts_count == 0)
+        parts_count = 1;
+
+    const char *temporary_directory = getenv("TMPDIR");
+    if (!temporary_directory || !temporary_directory[0])
+        temporary_directory = "/tmp";
+    vector<FILE *> part_files;
+    bool written = true;
+    for (long i = 0; i < parts_count && written; ++i) {
+        string part_file_name = string(temporary_directory) + "/stark_part_XXXXXX";
+        int fd = mkstemp(&part_file_name[0]);
+        FILE *part_file = fd < 0 ? nullptr : fdopen(fd, "w");
+        if (!part_file) {
+            LOG_ERROR("can not open file: %s", part_file_name.c_str());
+            if (fd >= 0) {
+                close(fd);
+                unlink(part_file_name.c_str());
+            }
+            written = false;
+            break;
+        }
+        part_file_names.push_back(part_file_name);
+        part_files.push_back(part_file);
+    }
+
+    // every line goes to the part of its segment, or of the segment its link starts from; other lines go to the first
+    // part, whose reader reports them. Lines keep their file order.
+    auto write_line = [&](const char *line, const char *window_end, long part) {
+        long len = line_len(line, window_end);
+        if (fwrite(line, 1, static_cast<size_t>(len), part_files[part]) != static_cast<size_t>(len) ||
+            (line[len - 1] != '\n' && fputc('\n', part_files[part]) == EOF))
+            written = false;
+    };
+    auto part_of = [&](const GfaField &name) -> long {
+        auto segment = segment_indices.find(GfaName{name.begin, name.len});
+        return segment == segment_indices.end() ? -1 : weights[parents[segment->second]];
+    };
+    if (written)
+        for_each_chunk(windows, threads_count, [&](GfaChunk &chunk, char *window_end) {
+            unsigned long segment_index = 0, link_index = 0, discarded_line_index = 0;
+            while (true) {
+                const char *segment_line = segment_index < chunk.segments.size() ? chunk.segments[segment_index].line
+                                                                                 : window_end;
+                const char *link_line = link_index < chunk.links.size() ? chunk.links[link_index].line : window_end;
+                const char *discarded_line = discarded_line_index < chunk.discarded_lines.size()
+                                             ? chunk.discarded_lines[discarded_line_index].begin : window_end;
+                if (segment_line < link_line && segment_line < discarded_line)
+                    write_line(segment_line, window_end, part_of(chunk.segments[segment_index++].name));
+                else if (link_line < discarded_line) {
+                    GfaLink &link = chunk.links[link_index++];
+                    long part = part_of(link.from_name);
+                    write_line(link_line, window_end, part >= 0 && part_of(link.to_name) >= 0 ? part : 0);
+                } else if (discarded_line < window_end) {
+                    write_line(discarded_line, window_end, 0);
+                    discarded_line_index++;
+                } else
+                    break;
+            }
+        });
+    if (windows.failed())
+        written = false;
+    for (FILE *part_file : part_files)
+        if (fclose(part_file) != 0)
+            written = false;
+    if (!written) {
+        LOG_ERROR("can not write the parts of file: %s", file_name);
+        for (auto &part_file_name : part_file_names)
+            unlink(part_file_name.c_str());
+        part_file_names.clear();
+        return false;
+    }
+    LOG_DEBUG("partitioned into %ld parts", parts_count);
+    return true;
+}
@@ -0,0 +1,37 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#ifndef STARK_GFA_READER_H
+#define STARK_GFA_READER_H
+
+/**
+ * reads a GFA1/GFA2 file, which may be gzip or BGZF compressed, into Node::graph; node sequences point into
+ * Node::graph->input_file, which must outlive them.
+ * The file is parsed by threads_count threads, each on a line-aligned part of it, then the parts are merged in file
+ * order, so the resulting graph does not depend on threads_count.
+ * @return k of the graph (overlap length of the links plus one), -1 if the file has no links, or -2 if the file
+ * could not be read
+ */
+int read_gfa(const char *file_name, int threads_count = 1, long max_node_ids = -1);
+
+/**
+ * splits a GFA file into part files in $TMPDIR (or /tmp), each holding whole weakly connected components, so that
+ * the parts can be processed one by one and no link crosses two parts. Components are packed into a part, in order
+ * of their first segments, while the estimated memory of the part stays within memory_budget bytes; a bigger
+ * component gets a part of its own. Lines keep their file order; unsupported lines and links to undefined segments
+ * go to the first part. Besides the part files only the segment names and two numbers per segment are held; a gzip
+ * file is decompressed again on each of the three passes over it, a window at a time, and the parts are written
+ * uncompressed.
+ * @param k set to k of the graph, or -1 if the file has no links
+ * @return false if the file could not be read or the parts could not be written
+ */
+bool partition_gfa(const char *file_name, size_t memory_budget, int &k, vector<string> &part_file_names,
+                   int threads_count = 1);
+
+#endif //STARK_GFA_READER_H
@@ -0,0 +1,192 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "gfa_writer.h"
+#include "utils/logger.h"
+#include "utils/gzip.h"
+#include "utils/parallel.h"
+
+using namespace std;
+
+#define WRITE_BLOCK_SIZE            65536L
+#define MAX_LONG_LEN                20
+#define MAX_LINK_LEN                (2 * MAX_LONG_LEN + 12)
+
+extern Logger *logger;
+
+/**
+ * a growing byte buffer that is written to through raw pointers
+ */
+class OutputBuffer {
+public:
+    /**
+     * @return a pointer to at least len free bytes after the content
+     */
+    char *reserve(size_t len) {
+        if (data.size() < size + len)
+            data.resize(max(data.size() * 2, size + len));
+        return data.data() + size;
+    }
+
+    void commit(char *end) {
+        size = end - data.data();
+    }
+
+    vector<char> data;
+    size_t size = 0;
+};
+
+/**
+ * writes value in decimal at out
+ * @return the end of the written digits
+ */
+static char *format_long(char *out, long value) {
+    char digits[MAX_LONG_LEN];
+    int digits_count = 0;
+    unsigned long rest = value < 0 ? -static_cast<unsigned long>(value) : static_cast<unsigned long>(value);
+    if (value < 0)
+        *out++ = '-';
+    do {
+        digits[digits_count++] = static_cast<char>('0' + rest % 10);
+        rest /= 10;
+    } while (rest != 0);
+    while (digits_count > 0)
+        *out++ = digits[--digits_count];
+    return out;
+}
+
+static char *format_link(char *out, long id, char side, long neighbour_id, long id_offset) {
+    *out++ = 'L';
+    *out++ = '\t';
+    out = format_long(out, id + id_offset);
+    *out++ = '\t';
+    *out++ = side;
+    *out++ = '\t';
+    out = format_long(out, (neighbour_id < 0 ? -neighbour_id : neighbour_id) + id_offset);
+    *out++ = '\t';
+    *out++ = neighbour_id < 0 ? '+' : '-';
+    memcpy(out, "\t0M\n", 4);
+    return out + 4;
+}
+
+static void format_segments(const FrozenGraph &graph, OutputBuffer &buffer, long begin, long end, long id_offset) {
+    for (long i = begin; i < end; ++i) {
+        int sequence_len = graph.sequence_len(i);
+        char *out = buffer.reserve(MAX_LONG_LEN + sequence_len + 4);
+        *out++ = 'S';
+        *out++ = '\t';
+        out = format_long(out, graph.id(i) + id_offset);
+        *out++ = '\t';
+        graph.sequence(i).copy_to(out, sequence_len);
+        out += sequence_len;
+        *out++ = '\n';
+        buffer.commit(out);
+    }
+}
+
+static void format_links(const FrozenGraph &graph, OutputBuffer &buffer, long begin, long end, long id_offset) {
+    for (long i = begin; i < end; ++i) {
+        long id = graph.id(i);
+        char *out = buffer.reserve(MAX_LINK_LEN * (graph.left_degree(i) + graph.right_degree(i)));
+        graph.for_each_neighbour(i, false, [&](long left_neighbour_id) {
+            out = format_link(out, id, '-', left_neighbour_id, id_offset);
+        });
+        graph.for_each_neighbour(i, true, [&](long right_neighbour_id) {
+            out = format_link(out, id, '+', right_neighbour_id, id_offset);
+        });
+        buffer.commit(out);
+    }
+}
+
+/**
+ * writes all of the buffers to fd in order, continuing after partial writes
+ */
+static bool write_buffers(int fd, vector<OutputBuffer> &buffers) {
+    vector<iovec> parts;
+    for (auto &buffer : buffers)
+        if (buffer.size > 0)
+            parts.push_back({buffer.data.data(), buffer.size});
+    size_t first_part = 0;
+    while (first_part < parts.size()) {
+        ssize_t written = writev(fd, parts.data() + first_part,
+                                 static_cast<int>(min(parts.size() - first_part, static_cast<size_t>(IOV_MAX))));
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        while (first_part < parts.size() && static_cast<size_t>(written) >= parts[first_part].iov_len)
+            written -= parts[first_part++].iov_len;
+        if (first_part < parts.size()) {
+            parts[first_part].iov_base = static_cast<char *>(parts[first_part].iov_base) + written;
+            parts[first_part].iov_len -= written;
+        }
+    }
+    return true;
+}
+
+bool write_gfa(const FrozenGraph &graph, const char *file_name, int threads_count, long id_offset, bool append) {
+    LOG_DEBUG("writing gfa file: %s", file_name);
+    bool to_stdout = strcmp(file_name, "-") == 0;
+    int fd = to_stdout ? STDOUT_FILENO : open(file_name, O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC), 0644);
+    if (fd < 0) {
+        LOG_ERROR("can not open file: %s", file_name);
+        return false;
+    }
+    if (threads_count < 1)
+        threads_count = 1;
+    size_t file_name_len = strlen(file_name);
+    bool compressed = file_name_len > 3 && strcmp(file_name + file_name_len - 3, ".gz") == 0;
+    vector<OutputBuffer> buffers(static_cast<unsigned long>(threads_count));
+    vector<OutputBuffer> compressed_buffers(static_cast<unsigned long>(compressed ? threads_count : 0));
+    vector<BgzfCompressor> compressors(static_cast<unsigned long>(compressed ? threads_count : 0));
+    bool written = true;
+    for (int section = 0; section < 2 && written; ++section)
+        for (long round_begin = 0; round_begin < graph.size() && written;
+             round_begin += WRITE_BLOCK_SIZE * threads_count) {
+            long round_end = min(round_begin + WRITE_BLOCK_SIZE * threads_count, graph.size());
+            parallel_ranges(round_begin, round_end, threads_count,
+                            [&](int thread_index, long range_begin, long range_end) {
+                                OutputBuffer &buffer = buffers[thread_index];
+                                buffer.size = 0;
+                                if (compressed)
+                                    compressed_buffers[thread_index].size = 0;
+                                if (section == 0)
+                                    format_segments(graph, buffer, range_begin, range_end, id_offset);
+                                else
+                                    format_links(graph, buffer, range_begin, range_end, id_offset);
+                                if (compressed) {
+                                    OutputBuffer &compressed_buffer = compressed_buffers[thread_index];
+                                    char *out = compressed_buffer.reserve(BgzfCompressor::bound(buffer.size));
+                                    compressed_buffer.commit(
+                                            out + compressors[thread_index].compress(buffer.data.data(), buffer.size,
+                                                                                     out));
+                                }
+                            });
+            written = write_buffers(fd, compressed ? compressed_buffers : buffers);
+        }
+    if (compressed && written) {
+        compressed_buffers.resize(1);
+        OutputBuffer &eof_buffer = compressed_buffers[0];
+        eof_buffer.size = 0;
+        char *out = eof_buffer.reserve(BGZF_EOF_SIZE);
+        memcpy(out, BGZF_EOF, BGZF_EOF_SIZE);
+        eof_buffer.commit(out + BGZF_EOF_SIZE);
+        written = write_buffers(fd, compressed_buffers);
+    }
+    if (!to_stdout && close(fd) != 0)
+        written = false;
+    if (!written)
+        LOG_ERROR("can not write file: %s", file_name);
+    else
+        LOG_DEBUG("write completed!");
+    return written;
+}
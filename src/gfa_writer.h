@@ -0,0 +1,22 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#ifndef STARK_GFA_WRITER_H
+#define STARK_GFA_WRITER_H
+
+#include "frozen_graph.h"
+
+/**
+ * writes graph as GFA1 to file_name, or to the standard output if file_name is "-": all segments, then all links,
+ * both in id order. Blocks of nodes are formatted by threads_count threads into their own buffers, which are
+ * then written in order, so the output does not depend on threads_count. A file name ending in .gz is written as BGZF,
+ * each thread compressing its own buffer.
+ * @param id_offset added to every node id written
+ * @param append whether to add to the end of the file instead of replacing it; appended BGZF is a new gzip member
+ * @return false if the output could not be opened or written
+ */
+bool write_gfa(const FrozenGraph &graph, const char *file_name, int threads_count = 1, long id_offset = 0,
+               bool append = false);
+
+#endif //STARK_GFA_WRITER_H
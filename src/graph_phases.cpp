@@ -0,0 +1,663 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <queue>
+#include <unordered_set>
+#include "graph_phases.h"
+#include "gfa_reader.h"
+#include "node.h"
+#include "utils/logger.h"
+#include "utils/parallel.h"
+#include "utils/sequence_compare.h"
+#include "utils/time_profile.h"
+
+using namespace std;
+
+#define MERGE_WINDOW_SIZE           16384L
+
+extern Logger *logger;
+int k = -1, statistics = 0;
+thread_local int threads_count = 1;
+bool pack_sequences = false;
+
+void print_statistics(int cur_k) {
+    if (statistics == 0)
+        return;
+    long total_nodes = Node::graph->nodes.size();
+    LOG_INFO("total_nodes: %ld", total_nodes);
+    if (statistics == 2) {
+        long total_edges = Node::graph->nodes.edges_count();
+        long total_letters = Node::graph->nodes.letters_count();
+        if (total_letters < total_nodes * cur_k)
+            LOG_FATAL("ERROR in cur_k during statistics!");
+        long total_not_unified_nodes = total_letters - total_nodes * (cur_k - 1);
+        long total_not_unified_edges = total_edges + total_not_unified_nodes - total_nodes;
+        LOG_DEBUGL2("total_edges: %ld", total_edges);
+        LOG_DEBUG("total_nodes (expanded): %ld", total_not_unified_nodes);
+        LOG_DEBUGL2("total_edges (expanded): %ld", total_not_unified_edges);
+        LOG_DEBUGL2("total_deadends: %ld", Node::graph->nodes.dead_ends_count());
+        LOG_DEBUG("total_letters: %ld", total_letters);
+    }
+}
+
+void clear_graph() {
+    Node::graph->nodes.clear();
+    Node::graph->last_id = 0;
+    Node::graph->sequences.clear();
+    delete Node::graph->input_file;
+    Node::graph->input_file = nullptr;
+}
+
+void compact_sequences() {
+    long letters_count = Node::graph->nodes.letters_count();
+    auto live_size = static_cast<size_t>((pack_sequences ? letters_count / 4 : letters_count) +
+                                         Node::graph->nodes.size());
+    MappedFile *&input_file = Node::graph->input_file;
+    size_t held_size = Node::graph->sequences.size() + (input_file ? input_file->size() : 0);
+    if (held_size < 2 * live_size)
+        return;
+    LOG_DEBUG("compacting sequences: %lu bytes held for %lu live bytes", held_size, live_size);
+    SequenceArena compacted_sequences;
+    for (long i = 1; i <= Node::graph->last_id; ++i)
+        if (Node::graph->nodes.contains(i)) {
+            SequenceRef &sequence = Node::graph->nodes.sequence(i);
+            sequence = compacted_sequences.store(sequence, static_cast<size_t>(Node::graph->nodes.sequence_len(i)),
+                                                 pack_sequences);
+        }
+    Node::graph->sequences.swap(compacted_sequences);
+    delete input_file;
+    input_file = nullptr;
+}
+
+/**
+ * hash of an edge given as a pair of node ids
+ */
+struct EdgeHash {
+    size_t operator()(const pair<long, long> &edge) const {
+        return static_cast<size_t>(edge.first) * 0x9E3779B97F4A7C15UL ^ static_cast<size_t>(edge.second);
+    }
+};
+
+void bluntify() {
+    LOG_DEBUG("bluntifying graph");
+    parallel_for(1, Node::graph->last_id + 1, threads_count, [](long i) {
+        if (!Node::graph->nodes.contains(i))
+            return;
+        Node node(i);
+        int from, to;
+        if (!node.left_edges.empty())
+            from = (k - 1) / 2;
+        else
+            from = 0;
+        if (!node.right_edges.empty())
+            to = node.sequence_len - k / 2;
+        else
+            to = node.sequence_len;
+        node.set_sequence(node.get_sequence() + from, to - from);
+    });
+    if (k % 2 == 0) {
+        long node_last_id = Node::graph->last_id;
+        // every node with an edge to the right side of a node gets a one letter node after it, taking all such edges;
+        // ids are handed out in node order, so the nodes can then be split independently
+        vector<long> split_node_ids(static_cast<unsigned long>(node_last_id + 1), 0);
+        parallel_for(1, node_last_id + 1, threads_count, [&](long i) {
+            if (Node::graph->nodes.contains(i) && !Node::graph->nodes.right_edges(i).empty() &&
+                Node::graph->nodes.right_edges(i).back() > 0)
+                split_node_ids[i] = 1;
+        });
+        for (long i = 1; i <= node_last_id; ++i)
+            if (split_node_ids[i] != 0)
+                split_node_ids[i] = ++Node::graph->last_id;
+        Node::graph->nodes.reserve(Node::graph->last_id);
+        parallel_for(1, node_last_id + 1, threads_count, [&](long i) {
+            long new_right_node_id = split_node_ids[i];
+            if (new_right_node_id == 0)
+                return;
+            Node node(i);
+            Node::graph->nodes.add(new_right_node_id, node.get_sequence() + node.sequence_len, 1);
+            vector<long> right_neighbour_ids;
+            for (long right_neighbour_id : node.right_edges)
+                if (right_neighbour_id > 0)
+                    right_neighbour_ids.push_back(right_neighbour_id);
+            for (long right_neighbour_id : right_neighbour_ids) {
+                Node::graph->nodes.erase_edge(node.id, true, right_neighbour_id);
+                if (right_neighbour_id == node.id) {
+                    Node::graph->nodes.insert_edge(new_right_node_id, true, node.id);
+                    Node::graph->nodes.insert_edge(node.id, true, new_right_node_id);
+                } else
+                    Node::graph->nodes.insert_edge(new_right_node_id, true, split_node_ids[right_neighbour_id]);
+            }
+            Node::graph->nodes.insert_edge(node.id, true, -1 * new_right_node_id);
+            Node::graph->nodes.insert_edge(new_right_node_id, false, node.id);
+        });
+        // left to left edges that were made while expanding, they must not be expanded again
+        unordered_set<pair<long, long>, EdgeHash> good_edges;
+        auto good_edge = [](long first_id, long second_id) {
+            return first_id < second_id ? pair<long, long>(first_id, second_id)
+                                        : pair<long, long>(second_id, first_id);
+        };
+        for (long i = 1; i <= node_last_id; ++i) {
+            if (!Node::graph->nodes.contains(i))
+                continue;
+            Node node(i);
+            auto left_edges = node.left_edges;
+            for (long left_neighbour_id : left_edges)
+                if (left_neighbour_id < 0 &&
+                    good_edges.find(good_edge(-1 * left_neighbour_id, node.id)) == good_edges.end()) {
+                    Node left_neighbour(-1 * left_neighbour_id);
+                    Node::graph->nodes.erase_edge(node.id, false, left_neighbour_id);
+                    Node::graph->nodes.erase_edge(left_neighbour.id, false, node.id * -1);
+                    long left_neighbour_right_edge_size =
+                            left_neighbour.sequence_len > 1 ? 1 : left_neighbour.right_edges.size();
+                    long node_right_edge_size = node.sequence_len > 1 ? 1 : node.right_edges.size();
+                    if (left_neighbour_right_edge_size == 0 || node_right_edge_size == 0)
+                        continue;
+                    Node *from_node, *to_node;
+                    if (left_neighbour_right_edge_size < node_right_edge_size) {
+                        from_node = &left_neighbour;
+                        to_node = &node;
+                    } else {
+                        from_node = &node;
+                        to_node = &left_neighbour;
+                    }
+                    if (from_node->sequence_len > 1) {
+                        long expanded_node_id = Node::add_node(from_node->get_sequence() + 1,
+                                                               from_node->sequence_len - 1);
+                        from_node->set_sequence(from_node->get_sequence(), 1);
+                        Node expanded_node(expanded_node_id);
+                        from_node->move_right_edges_to(expanded_node);
+                        Node::add_edge(from_node->id, '+', expanded_node_id, '+');
+                    }
+                    for (long right_neighbour_id : from_node->right_edges)
+                        if (right_neighbour_id < 0) {
+                            Node::add_edge(-1 * right_neighbour_id, '-', to_node->id, '+');
+                            good_edges.insert(good_edge(-1 * right_neighbour_id, to_node->id));
+                        } else
+                            Node::add_edge(right_neighbour_id, '+', to_node->id, '+');
+                }
+        }
+    }
+}
+
+/**
+ * glues node to its left neighbour if each is the other's only neighbour on that side
+ */
+static void unify_to_left_neighbour(Node &node, int cur_k) {
+    int cur_k_1 = cur_k - 1;
+    if (node.left_edges.size() != 1)
+        return;
+    long left_neighbour_id = node.left_edges.front();
+    if (left_neighbour_id < 0)
+        return;
+    Node left_neighbour(left_neighbour_id);
+    if (left_neighbour.right_edges.size() != 1)
+        return;
+    if (left_neighbour.id == node.id)
+        return;
+    node.move_right_edges_to(left_neighbour, false);
+    SequenceRef after_left_neighbour_sequence = left_neighbour.get_sequence() + left_neighbour.sequence_len;
+    int new_letters = node.sequence_len - cur_k_1;
+    bool new_char_needed = !extends_in_place(after_left_neighbour_sequence, node.get_sequence() + cur_k_1,
+                                             new_letters);
+    int new_sequence_len = left_neighbour.sequence_len + node.sequence_len - cur_k_1;
+    if (!new_char_needed)
+        left_neighbour.set_sequence(left_neighbour.get_sequence(), new_sequence_len);
+    else {
+        char *new_sequence = Node::graph->sequences.allocate(static_cast<size_t>(new_sequence_len));
+        left_neighbour.get_sequence().copy_to(new_sequence, left_neighbour.sequence_len);
+        (node.get_sequence() + cur_k_1).copy_to(new_sequence + left_neighbour.sequence_len, new_letters);
+        left_neighbour.set_sequence(new_sequence, new_sequence_len);
+    }
+    Node::graph->nodes.erase(node.id);
+}
+
+/**
+ * @return the node after node on its unitig: its only right neighbour, if node is the only left neighbour of it;
+ * otherwise 0
+ */
+static long next_on_unitig(long id) {
+    Edges &right_edges = Node::graph->nodes.right_edges(id);
+    if (right_edges.size() != 1 || right_edges.front() >= 0 || right_edges.front() == -1 * id)
+        return 0;
+    long next_id = -1 * right_edges.front();
+    Edges &next_left_edges = Node::graph->nodes.left_edges(next_id);
+    return next_left_edges.size() == 1 && next_left_edges.front() == id ? next_id : 0;
+}
+
+/**
+ * adds node and all of its neighbours to nodes
+ */
+static void add_neighbourhood(Node &node, vector<long> &nodes) {
+    nodes.push_back(node.id);
+    for (long left_neighbour_id : node.left_edges)
+        nodes.push_back(abs(left_neighbour_id));
+    for (long right_neighbour_id : node.right_edges)
+        nodes.push_back(abs(right_neighbour_id));
+}
+
+/**
+ * @return the node before node on its unitig, the one node is next_on_unitig of; otherwise 0
+ */
+static long previous_on_unitig(long id) {
+    Edges &left_edges = Node::graph->nodes.left_edges(id);
+    if (left_edges.size() != 1 || left_edges.front() <= 0)
+        return 0;
+    return next_on_unitig(left_edges.front()) == id ? left_edges.front() : 0;
+}
+
+/**
+ * glues the unitig that starts at first_id into its first node, taking the nodes after a node from next(id), and
+ * erases the nodes between the first and the last one; the right edges of the last node are left to the caller
+ * @return the id of the last node
+ */
+template<typename Next>
+static long glue_unitig(long first_id, int cur_k, SequenceArena &arena, Next next) {
+    int cur_k_1 = cur_k - 1;
+    SequenceRef &sequence = Node::graph->nodes.sequence(first_id);
+    int sequence_len = Node::graph->nodes.sequence_len(first_id);
+    int unitig_len = sequence_len;
+    bool in_place = true;
+    long last_node_id = first_id;
+    for (long j = next(first_id); j; j = next(j)) {
+        int new_letters = max(Node::graph->nodes.sequence_len(j) - cur_k_1, 0);
+        in_place = in_place && extends_in_place(sequence + unitig_len, Node::graph->nodes.sequence(j) + cur_k_1,
+                                                new_letters);
+        unitig_len += new_letters;
+        last_node_id = j;
+    }
+    if (!in_place) {
+        char *unitig_sequence = arena.allocate(static_cast<size_t>(unitig_len));
+        sequence.copy_to(unitig_sequence, sequence_len);
+        char *unitig_end = unitig_sequence + sequence_len;
+        for (long j = next(first_id); j; j = next(j)) {
+            int new_letters = max(Node::graph->nodes.sequence_len(j) - cur_k_1, 0);
+            (Node::graph->nodes.sequence(j) + cur_k_1).copy_to(unitig_end, new_letters);
+            unitig_end += new_letters;
+        }
+        sequence = unitig_sequence;
+    }
+    Node::graph->nodes.set_sequence_len(first_id, unitig_len);
+    for (long j = next(first_id), next_id; j != last_node_id; j = next_id) {
+        next_id = next(j);
+        Node::graph->nodes.erase(j);
+    }
+    return last_node_id;
+}
+
+void unify(int cur_k) {
+    LOG_DEBUG("unifying");
+    long last_id = Node::graph->last_id;
+    vector<long> next_ids(static_cast<unsigned long>(last_id + 1), 0);
+    vector<char> has_previous(static_cast<unsigned long>(last_id + 1), 0);
+    parallel_for(1, last_id + 1, threads_count, [&](long i) {
+        if (!Node::graph->nodes.contains(i))
+            return;
+        next_ids[i] = next_on_unitig(i);
+        if (next_ids[i])
+            has_previous[next_ids[i]] = 1;
+    });
+
+    vector<SequenceArena> arenas(static_cast<unsigned long>(threads_count));
+    vector<vector<pair<long, long>>> unitig_ends(static_cast<unsigned long>(threads_count));
+    parallel_ranges(1, last_id + 1, threads_count, [&](int thread_index, long range_begin, long range_end) {
+        for (long i = range_begin; i < range_end; ++i)
+            if (next_ids[i] != 0 && !has_previous[i])
+                unitig_ends[thread_index].emplace_back(i, glue_unitig(i, cur_k, arenas[thread_index], [&](long j) {
+                    return next_ids[j];
+                }));
+    });
+    for (auto &arena : arenas)
+        Node::graph->sequences.absorb(arena);
+    for (auto &thread_unitig_ends : unitig_ends)
+        for (auto &unitig_end : thread_unitig_ends) {
+            Node first_node(unitig_end.first), last_node(unitig_end.second);
+            last_node.move_right_edges_to(first_node, false);
+            Node::graph->nodes.erase(last_node.id);
+        }
+
+    // the nodes of unitigs with a first node are all erased by now, so the ones left with a previous node are on
+    // cycles
+    for (long i = 1; i <= last_id; ++i)
+        if (has_previous[i] && Node::graph->nodes.contains(i)) {
+            Node node(i);
+            unify_to_left_neighbour(node, cur_k);
+        }
+}
+
+/**
+ * unify(cur_k) for the unitigs through the given nodes, which must include every node whose edges changed since the
+ * graph was last unified, so that the other unitigs are single nodes; runs on this thread
+ * @param touched gets the nodes that were glued to and their neighbours added
+ */
+static void unify_around(int cur_k, const vector<long> &ids, vector<long> &touched) {
+    vector<long> cycle;
+    for (long id : ids) {
+        if (!Node::graph->nodes.contains(id))
+            continue;
+        long first_id = id;
+        for (long previous_id; (previous_id = previous_on_unitig(first_id)) != 0 && previous_id != id;)
+            first_id = previous_id;
+        if (previous_on_unitig(first_id) != 0) {
+            // on a cycle, nodes are glued to their left neighbours in id order, as unify does
+            cycle.clear();
+            long j = id;
+            do {
+                cycle.push_back(j);
+                j = next_on_unitig(j);
+            } while (j != id);
+            sort(cycle.begin(), cycle.end());
+            for (long cycle_id : cycle)
+                if (Node::graph->nodes.contains(cycle_id)) {
+                    Node node(cycle_id);
+                    unify_to_left_neighbour(node, cur_k);
+                }
+            for (long cycle_id : cycle)
+                if (Node::graph->nodes.contains(cycle_id)) {
+                    Node node(cycle_id);
+                    add_neighbourhood(node, touched);
+                }
+            continue;
+        }
+        if (next_on_unitig(first_id) == 0)
+            continue;
+        Node first_node(first_id), last_node(glue_unitig(first_id, cur_k, Node::graph->sequences, next_on_unitig));
+        last_node.move_right_edges_to(first_node, false);
+        Node::graph->nodes.erase(last_node.id);
+        add_neighbourhood(first_node, touched);
+    }
+}
+
+void renumber_nodes() {
+    NodeTable &nodes = Node::graph->nodes;
+    long last_id = Node::graph->last_id;
+    LOG_DEBUG("renumbering");
+    // order[j] is the node that gets id j + 1; it also serves as the queue of the breadth-first search
+    vector<long> new_ids(static_cast<unsigned long>(last_id + 1), 0), order;
+    order.reserve(static_cast<unsigned long>(nodes.size()));
+    for (long root = 1; root <= last_id; ++root) {
+        if (!nodes.contains(root) || new_ids[root] != 0)
+            continue;
+        new_ids[root] = static_cast<long>(order.size()) + 1;
+        order.push_back(root);
+        for (unsigned long j = order.size() - 1; j < order.size(); ++j) {
+            long id = order[j];
+            for (Edges *edges : {&nodes.left_edges(id), &nodes.right_edges(id)})
+                for (long neighbour_id : *edges)
+                    if (new_ids[abs(neighbour_id)] == 0) {
+                        new_ids[abs(neighbour_id)] = static_cast<long>(order.size()) + 1;
+                        order.push_back(abs(neighbour_id));
+                    }
+        }
+    }
+
+    auto nodes_count = static_cast<long>(order.size());
+    NodeTable renumbered_nodes;
+    renumbered_nodes.reserve(nodes_count);
+    parallel_ranges(0, nodes_count, threads_count, [&](int, long range_begin, long range_end) {
+        vector<long> neighbour_ids;
+        for (long j = range_begin; j < range_end; ++j) {
+            long id = order[j];
+            renumbered_nodes.add(j + 1, nodes.sequence(id), nodes.sequence_len(id));
+            for (bool right_side : {false, true}) {
+                neighbour_ids.clear();
+                for (long neighbour_id : right_side ? nodes.right_edges(id) : nodes.left_edges(id))
+                    neighbour_ids.push_back(neighbour_id < 0 ? -new_ids[-neighbour_id] : new_ids[neighbour_id]);
+                sort(neighbour_ids.begin(), neighbour_ids.end());
+                renumbered_nodes.assign_edges(j + 1, right_side, neighbour_ids.data(),
+                                              static_cast<int>(neighbour_ids.size()));
+                nodes.clear_edges(id, right_side);
+            }
+        }
+    });
+    nodes.swap(renumbered_nodes);
+    Node::graph->last_id = nodes_count;
+}
+
+/**
+ * adds the nodes on the given side of neighbour that may merge to node: for a non-empty neighbour set on a side of
+ * node those with the same set, for an empty one the dead-ends on that side
+ */
+static void add_merge_candidates(Node &node, long neighbour_id, bool left_side, vector<long> &candidates,
+                                 vector<long> &reads) {
+    Edges &node_edges = left_side ? node.left_edges : node.right_edges;
+    reads.push_back(abs(neighbour_id));
+    for (long candidate_id : neighbour_id < 0 ? Node::graph->nodes.left_edges(-1 * neighbour_id)
+                                              : Node::graph->nodes.right_edges(neighbour_id)) {
+        if (abs(candidate_id) == node.id)
+            continue;
+        reads.push_back(abs(candidate_id));
+        Edges &candidate_edges = left_side ? Node::graph->nodes.left_edges(abs(candidate_id))
+                                           : Node::graph->nodes.right_edges(abs(candidate_id));
+        if (candidate_edges == node_edges)
+            candidates.push_back(candidate_id);
+    }
+}
+
+/**
+ * fills candidates with the signed ids of nodes that have the same left or the same right neighbours as node, sorted,
+ * and adds the nodes this depends on to reads.
+ * All nodes sharing a non-empty neighbour set are neighbours of its first member, and dead-ends that can merge to node
+ * hang from the first or last neighbour on its other side, so the adjacency lists serve as the signature groups.
+ */
+static void find_merge_candidates(Node &node, vector<long> &candidates, vector<long> &reads) {
+    candidates.clear();
+    if (!node.left_edges.empty())
+        add_merge_candidates(node, node.left_edges.front(), true, candidates, reads);
+    else if (!node.right_edges.empty()) {
+        add_merge_candidates(node, node.right_edges.front(), true, candidates, reads);
+        add_merge_candidates(node, node.right_edges.back(), true, candidates, reads);
+    }
+    if (!node.right_edges.empty())
+        add_merge_candidates(node, node.right_edges.front(), false, candidates, reads);
+    else if (!node.left_edges.empty()) {
+        add_merge_candidates(node, node.left_edges.front(), false, candidates, reads);
+        add_merge_candidates(node, node.left_edges.back(), false, candidates, reads);
+    }
+    sort(candidates.begin(), candidates.end());
+    candidates.erase(unique(candidates.begin(), candidates.end()), candidates.end());
+}
+
+/**
+ * finds the first candidate node would be merged with, without changing the graph
+ * @param reads gets every node the decision depends on appended
+ * @return signed id of the candidate, positive for a left merge and negative for a right merge, or 0
+ */
+static long decide_merge(Node &node, bool growing_merge, vector<long> &candidates, vector<long> &reads) {
+    reads.push_back(node.id);
+    find_merge_candidates(node, candidates, reads);
+    for (auto candidate_id : candidates) {
+        Node candidate_node(abs(candidate_id));
+        if (candidate_node.left_edges.find(candidate_node.id))
+            continue;
+        if (candidate_node.left_edges.find(-1 * candidate_node.id))
+            continue;
+        if (candidate_node.right_edges.find(candidate_node.id))
+            continue;
+        if (candidate_node.right_edges.find(-1 * candidate_node.id))
+            continue;
+        if (candidate_node.left_edges == node.left_edges &&
+            candidate_node.can_partial_left_merge_to(node, growing_merge))
+            return candidate_node.id;
+        if (candidate_node.right_edges == node.right_edges &&
+            candidate_node.can_partial_right_merge_to(node, growing_merge))
+            return -1 * candidate_node.id;
+    }
+    return 0;
+}
+
+void merge_nodes(bool growing_merge) {
+    LOG_DEBUG("merging");
+//    unordered_map<char, Node *> end_right_nodes;
+//    unordered_map<char, Node *> end_left_nodes;
+//    for (long i = 1; i <= Node::graph->last_id; ++i) {
+//        if (!Node::graph->nodes.contains(i))
+//            continue;
+//        Node node(i);
+//        if (node.right_edges.empty()) {
+//            const auto &end_right_node = end_right_nodes.find(node.get_sequence()[node.sequence_len - 1]);
+//            if (end_right_node == end_right_nodes.end() ||
+//                node.partial_right_merge_to(*end_right_node->second, growing_merge) == node.id)
+//                end_right_nodes[node.get_sequence()[node.sequence_len - 1]] = &node;
+//        }
+//        if (node.left_edges.empty()) {
+//            const auto &end_left_node = end_left_nodes.find(node.get_sequence()[0]);
+//            if (end_left_node == end_left_nodes.end() ||
+//                node.partial_left_merge_to(*end_left_node->second, growing_merge) == node.id)
+//                end_left_nodes[node.get_sequence()[0]] = &node;
+//        }
+//    }
+    struct WindowDecision {
+        long decision;
+        int thread_index;
+        long reads_begin;
+        long reads_end;
+    };
+    vector<long> candidates, reads, writes, write_windows, window_ids, next_step_ids, unify_ids, touched;
+    vector<WindowDecision> window_decisions(MERGE_WINDOW_SIZE);
+    vector<vector<long>> threads_candidates(static_cast<unsigned long>(threads_count));
+    vector<vector<long>> threads_reads(static_cast<unsigned long>(threads_count));
+    // a node is looked at again only when a node within two links of it, which its decision reads, has changed. The
+    // nodes after the one being looked at are queued for this step, the others for the next one, so the merges are
+    // those of looking at every node in id order in every step
+    priority_queue<long, vector<long>, greater<long>> step_ids;
+    vector<int> queued_steps;
+    long window = 0, position = 0;
+    int step = 0;
+    auto queue_node = [&](long id) {
+        int queue_step = id > position ? step : step + 1;
+        if (id >= static_cast<long>(queued_steps.size()))
+            queued_steps.resize(static_cast<unsigned long>(Node::graph->last_id + 1), -1);
+        if (queued_steps[id] >= queue_step)
+            return;
+        queued_steps[id] = queue_step;
+        if (queue_step == step)
+            step_ids.push(id);
+        else
+            next_step_ids.push_back(id);
+    };
+    auto queue_around = [&](long id) {
+        if (!Node::graph->nodes.contains(id))
+            return;
+        queue_node(id);
+        for (Edges *edges : {&Node::graph->nodes.left_edges(id), &Node::graph->nodes.right_edges(id)})
+            for (long neighbour_id : *edges) {
+                queue_node(abs(neighbour_id));
+                Node neighbour(abs(neighbour_id));
+                for (long second_neighbour_id : neighbour.left_edges)
+                    queue_node(abs(second_neighbour_id));
+                for (long second_neighbour_id : neighbour.right_edges)
+                    queue_node(abs(second_neighbour_id));
+            }
+    };
+    long changed = 1;
+    while (changed > 0) {
+        changed = 0;
+        position = 0;
+        begin_phase("merge step " + to_string(step));
+        if (step == 0) {
+            unify(1);
+            for (long i = 1; i <= Node::graph->last_id; ++i)
+                if (Node::graph->nodes.contains(i))
+                    queue_node(i);
+        } else {
+            // only the unitigs through nodes written in the last step can be longer than one node
+            sort(unify_ids.begin(), unify_ids.end());
+            unify_ids.erase(unique(unify_ids.begin(), unify_ids.end()), unify_ids.end());
+            touched.clear();
+            unify_around(1, unify_ids, touched);
+            unify_ids.clear();
+            for (long id : next_step_ids)
+                step_ids.push(id);
+            next_step_ids.clear();
+            for (long id : touched)
+                queue_around(id);
+        }
+        compact_sequences();
+        LOG_INFO("Try to merge step %d for %ld nodes, %lu to look at", step, Node::graph->nodes.size(),
+                 step_ids.size());
+        long i_debug_step = max(static_cast<long>(step_ids.size()) / 10, 1L), looked_at = 0;
+        // decisions for a window of nodes are made in parallel on the graph as it is before the window; they are then
+        // applied in id order, and a decision is made again if a merge earlier in the window wrote a node it read.
+        // Nodes queued while the window is applied are decided when their turn comes
+        for (; !step_ids.empty(); window++) {
+            long window_end = step_ids.top() + MERGE_WINDOW_SIZE;
+            window_ids.clear();
+            while (!step_ids.empty() && step_ids.top() < window_end) {
+                window_ids.push_back(step_ids.top());
+                step_ids.pop();
+            }
+            parallel_ranges(0, static_cast<long>(window_ids.size()), threads_count,
+                            [&](int thread_index, long range_begin, long range_end) {
+                                vector<long> &thread_reads = threads_reads[thread_index];
+                                thread_reads.clear();
+                                for (long j = range_begin; j < range_end; ++j)
+                                    if (Node::graph->nodes.contains(window_ids[j])) {
+                                        Node node(window_ids[j]);
+                                        WindowDecision &window_decision = window_decisions[j];
+                                        window_decision.thread_index = thread_index;
+                                        window_decision.reads_begin = thread_reads.size();
+                                        window_decision.decision = decide_merge(
+                                                node, growing_merge, threads_candidates[thread_index], thread_reads);
+                                        window_decision.reads_end = thread_reads.size();
+                                    }
+                            });
+            for (unsigned long j = 0;;) {
+                long i;
+                bool decided = j < window_ids.size() &&
+                               (step_ids.empty() || step_ids.top() >= window_end || window_ids[j] < step_ids.top());
+                if (decided)
+                    i = window_ids[j++];
+                else if (!step_ids.empty() && step_ids.top() < window_end) {
+                    i = step_ids.top();
+                    step_ids.pop();
+                } else
+                    break;
+                position = i;
+                if (++looked_at % i_debug_step == 0)
+                    LOG_DEBUGL3("merge i: %ld", i);
+                if (!Node::graph->nodes.contains(i))
+                    continue;
+                Node node(i);
+                long decision = 0;
+                if (decided) {
+                    WindowDecision &window_decision = window_decisions[j - 1];
+                    decision = window_decision.decision;
+                    const long *window_reads = threads_reads[window_decision.thread_index].data();
+                    for (long l = window_decision.reads_begin; l < window_decision.reads_end; ++l)
+                        if (window_reads[l] < static_cast<long>(write_windows.size()) &&
+                            write_windows[window_reads[l]] == window) {
+                            decided = false;
+                            break;
+                        }
+                }
+                if (!decided) {
+                    reads.clear();
+                    decision = decide_merge(node, growing_merge, candidates, reads);
+                }
+                if (decision == 0)
+                    continue;
+                Node candidate_node(abs(decision));
+                writes.clear();
+                add_neighbourhood(node, writes);
+                add_neighbourhood(candidate_node, writes);
+                writes.push_back(decision > 0 ? candidate_node.partial_left_merge_to(node, growing_merge)
+                                              : candidate_node.partial_right_merge_to(node, growing_merge));
+                write_windows.resize(static_cast<unsigned long>(Node::graph->last_id + 1), -1);
+                for (long write_id : writes) {
+                    write_windows[write_id] = window;
+                    unify_ids.push_back(write_id);
+                    queue_around(write_id);
+                }
+                LOG_DEBUGL4("%ld\t%s\n%ld\t%s\n\n", i, node.get_sequence().to_string(node.sequence_len).c_str(),
+                            candidate_node.id,
+                            candidate_node.get_sequence().to_string(candidate_node.sequence_len).c_str());
+                changed++;
+            }
+        }
+        end_phase();
+        step++;
+    }
+}
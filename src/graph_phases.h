@@ -0,0 +1,58 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#include "sequence_arena.h"
+
+#ifndef STARK_GRAPH_PHASES_H
+#define STARK_GRAPH_PHASES_H
+
+extern int k, statistics;
+extern thread_local int threads_count; // threads of the phases, 1 unless the thread sets it
+extern bool pack_sequences; // whether compact_sequences packs ACGT sequences in 2 bits a letter
+
+/**
+ * logs the size of the graph, and for statistics level 2 also its edges, dead-ends and letters as if it had cur_k.
+ * The counts are kept by Node::graph, so this takes constant time.
+ */
+void print_statistics(int cur_k);
+
+/**
+ * removes all nodes and frees their sequences and the input file
+ */
+void clear_graph();
+
+/**
+ * copies the sequences of live nodes into a new arena, packed if pack_sequences is set, and frees the old one,
+ * together with the input file once no node points into it. Does nothing while dead sequences take less room than the
+ * live ones.
+ */
+void compact_sequences();
+
+/**
+ * trims node sequences so that linked nodes no longer overlap; for even k, adds one letter nodes where the overlaps of
+ * opposite sides do not split evenly
+ */
+void bluntify();
+
+/**
+ * glues every unitig into its first node. Unitigs are found and their sequences built on threads_count threads, one
+ * allocation per unitig; the right edges of their last nodes are then moved over serially. Unitigs that close into a
+ * cycle have no first node and are glued one node at a time, in id order.
+ */
+void unify(int cur_k);
+
+/**
+ * gives the live nodes the ids 1 to their count in breadth-first order from the smallest id of each component, so
+ * that linked nodes get close ids and the output has no gaps in its ids; edges are rewritten on threads_count threads
+ */
+void renumber_nodes();
+
+/**
+ * merges nodes that share their neighbours on a side and a prefix or suffix, step by step until no merge is left;
+ * growing_merge also allows merges that add a node for the shared part. After the first step, a step only looks at
+ * the nodes near the ones the step before changed.
+ */
+void merge_nodes(bool growing_merge = false);
+
+#endif //STARK_GRAPH_PHASES_H
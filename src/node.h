@@ -2,8 +2,11 @@
  * @author Hassan Nikaein
  */
 
-#include <unordered_map>
-#include <vector>
+#include <utility>
+#include "edges.h"
+#include "node_table.h"
+#include "sequence_arena.h"
+#include "utils/mapped_file.h"
 
 using namespace std;
 
@@ -11,70 +14,53 @@ using namespace std;
 #define STARK_NODE_H
 
 
-class Edges {
-private:
-    class EdgesIterator {
-    private:
-        Edges *edges;
-        int index;
-    public:
-        EdgesIterator() = delete;
-
-        explicit EdgesIterator(Edges *edges, int index);
-
-        bool operator!=(const EdgesIterator &edgesIterator);
-
-        void operator++();
-
-        long operator*();
-    };
-
-    vector<long> neighbour_ids;
-public:
-    bool empty();
-
-    long size();
-
-    void erase(long id);
-
-    void insert(long id);
-
-    void clear();
-
-    void merge_with(const Edges &another_edges);
-
-    bool find(long id);
-
-    long front();
-
-    long back();
-
-    long get(int index);
-
-    EdgesIterator begin();
-
-    EdgesIterator end();
-
-    bool operator==(Edges &another_edges);
+/**
+ * The nodes of a graph and the sequences made for them while it is processed
+ */
+struct Graph {
+    NodeTable nodes;
+    long last_id = 0;
+    SequenceArena sequences;
+    MappedFile *input_file = nullptr; // the read file node sequences may point into
+
+    /**
+     * exchanges the contents of two graphs; node sequences keep their addresses
+     */
+    void swap(Graph &other) {
+        nodes.swap(other.nodes);
+        std::swap(last_id, other.last_id);
+        sequences.swap(other.sequences);
+        std::swap(input_file, other.input_file);
+    }
 };
 
+/**
+ * A handle to one node of the current graph, Node::graph. The fields are references into the table columns, so a
+ * handle is cheap to create and stays valid while nodes are added. Sequences and edges are changed through the
+ * methods of Node or Node::graph->nodes, which keep the graph statistics.
+ */
 class Node {
 public:
-    static long last_id;
-    static unordered_map<long, Node> nodes;
+    static Graph main_graph;
+
+    /**
+     * the graph Node and the phases work on in this thread, main_graph unless the thread sets another one. Threads
+     * started by a thread with another graph still start on main_graph.
+     */
+    static thread_local Graph *graph;
 
     long id;
-    int sequence_len;
-    Edges left_edges;
-    Edges right_edges;
+    const int &sequence_len;
+    Edges &left_edges;
+    Edges &right_edges;
 
-    explicit Node(char *sequence, int sequence_len, long left_neighbour_id = 0, long right_neighbour_id = 0);
+    explicit Node(long id);
 
     Node() = delete;
 
-    void set_sequence(char *new_sequence, int new_sequence_len);
+    void set_sequence(SequenceRef new_sequence, int new_sequence_len);
 
-    char *get_sequence();
+    SequenceRef get_sequence();
 
     void merge_to(Node &node);
 
@@ -82,14 +68,22 @@ public:
 
     long partial_right_merge_to(Node &node, bool growing_merge);
 
+    /**
+     * @return whether partial_left_merge_to(node, growing_merge) would merge anything, without changing the graph
+     */
+    bool can_partial_left_merge_to(Node &node, bool growing_merge);
+
+    bool can_partial_right_merge_to(Node &node, bool growing_merge);
+
     void move_right_edges_to(Node &node, bool update = true);
 
-    static long add_node(char *sequence, int sequence_len, long left_neighbour_id = 0, long right_neighbour_id = 0);
+    static long add_node(SequenceRef sequence, int sequence_len, long left_neighbour_id = 0,
+                         long right_neighbour_id = 0);
 
     static void add_edge(long from_node_id, char from_side, long to_node_id, char to_side);
 
 private:
-    char *sequence;
+    SequenceRef &sequence;
 
     void move_left_edges_to(Node &node, bool update = true);
 };
@@ -0,0 +1,110 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#include <utility>
+#include "node_table.h"
+
+long NodeTable::size() const {
+    return live_count;
+}
+
+long NodeTable::edges_count() const {
+    return edge_ends_count / 2;
+}
+
+long NodeTable::dead_ends_count() const {
+    return empty_sides_count;
+}
+
+long NodeTable::letters_count() const {
+    return letters;
+}
+
+/**
+ * makes ids up to id addressable, so that they can be added from several threads
+ */
+void NodeTable::reserve(long id) {
+    sequences.ensure(id);
+    sequence_lens.ensure(id);
+    left_edges_column.ensure(id);
+    right_edges_column.ensure(id);
+    live_bits.ensure(id >> 6);
+}
+
+void NodeTable::add(long id, SequenceRef sequence, int sequence_len) {
+    reserve(id);
+    sequences[id] = sequence;
+    sequence_lens[id] = sequence_len;
+    __atomic_fetch_or(&live_bits[id >> 6], 1UL << (id & 63), __ATOMIC_RELAXED);
+    live_count++;
+    letters.fetch_add(sequence_len, memory_order_relaxed);
+    count_side(left_edges_column[id].size(), 1);
+    count_side(right_edges_column[id].size(), 1);
+}
+
+void NodeTable::erase(long id) {
+    if (!contains(id))
+        return;
+    __atomic_fetch_and(&live_bits[id >> 6], ~(1UL << (id & 63)), __ATOMIC_RELAXED);
+    live_count--;
+    letters.fetch_sub(sequence_lens[id], memory_order_relaxed);
+    count_side(left_edges_column[id].size(), -1);
+    count_side(right_edges_column[id].size(), -1);
+    left_edges_column[id] = Edges();
+    right_edges_column[id] = Edges();
+}
+
+/**
+ * adds (sign 1) or removes (sign -1) a side of size edges to the counts
+ */
+void NodeTable::count_side(long size, int sign) {
+    edge_ends_count.fetch_add(sign * size, memory_order_relaxed);
+    if (size == 0)
+        empty_sides_count.fetch_add(sign, memory_order_relaxed);
+}
+
+void NodeTable::clear_edges(long id, bool right_side) {
+    Edges &edges = right_side ? right_edges_column[id] : left_edges_column[id];
+    count_side_change(edges.size(), 0);
+    edges.clear();
+}
+
+void NodeTable::merge_edges(long id, bool right_side, const Edges &another_edges) {
+    Edges &edges = right_side ? right_edges_column[id] : left_edges_column[id];
+    long old_size = edges.size();
+    edges.merge_with(another_edges);
+    count_side_change(old_size, edges.size());
+}
+
+void NodeTable::assign_edges(long id, bool right_side, const long *ids, int count) {
+    Edges &edges = right_side ? right_edges_column[id] : left_edges_column[id];
+    long old_size = edges.size();
+    edges.assign(ids, count);
+    count_side_change(old_size, edges.size());
+}
+
+void NodeTable::swap(NodeTable &another_table) {
+    for (auto counts : {make_pair(&live_count, &another_table.live_count),
+                        make_pair(&edge_ends_count, &another_table.edge_ends_count),
+                        make_pair(&empty_sides_count, &another_table.empty_sides_count),
+                        make_pair(&letters, &another_table.letters)})
+        *counts.first = counts.second->exchange(*counts.first);
+    live_bits.swap(another_table.live_bits);
+    sequences.swap(another_table.sequences);
+    sequence_lens.swap(another_table.sequence_lens);
+    left_edges_column.swap(another_table.left_edges_column);
+    right_edges_column.swap(another_table.right_edges_column);
+}
+
+void NodeTable::clear() {
+    live_count = 0;
+    edge_ends_count = 0;
+    empty_sides_count = 0;
+    letters = 0;
+    live_bits.clear();
+    sequences.clear();
+    sequence_lens.clear();
+    left_edges_column.clear();
+    right_edges_column.clear();
+}
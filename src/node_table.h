@@ -0,0 +1,136 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#include <atomic>
+#include <cstdint>
+#include "edges.h"
+#include "sequence_ref.h"
+#include "utils/chunked_array.h"
+
+#ifndef STARK_NODE_TABLE_H
+#define STARK_NODE_TABLE_H
+
+
+/**
+ * Dense id-indexed storage of all nodes, one column per field (struct of arrays) plus a bitmap of live ids.
+ * Id 0 is never used. Columns grow in chunks, so references into them survive adding nodes. Different ids can be
+ * erased and looked up concurrently, and added concurrently once reserved. The counts of edges, dead-ends and letters
+ * of the live nodes are kept up to date, so sequence lengths and edges must be changed through the table.
+ */
+class NodeTable {
+public:
+    long size() const;
+
+    long edges_count() const;
+
+    /**
+     * @return the sides of live nodes without any edge
+     */
+    long dead_ends_count() const;
+
+    long letters_count() const;
+
+    bool contains(long id) const;
+
+    void reserve(long id);
+
+    void add(long id, SequenceRef sequence, int sequence_len);
+
+    void erase(long id);
+
+    void clear();
+
+    /**
+     * exchanges all nodes with another_table; handles to nodes of either table are invalidated
+     */
+    void swap(NodeTable &another_table);
+
+    SequenceRef &sequence(long id);
+
+    int &sequence_len(long id);
+
+    Edges &left_edges(long id);
+
+    Edges &right_edges(long id);
+
+    void set_sequence_len(long id, int sequence_len);
+
+    void insert_edge(long id, bool right_side, long neighbour_id);
+
+    void erase_edge(long id, bool right_side, long neighbour_id);
+
+    void clear_edges(long id, bool right_side);
+
+    void merge_edges(long id, bool right_side, const Edges &edges);
+
+    /**
+     * replaces the edges on a side with count ids, which must be sorted and distinct
+     */
+    void assign_edges(long id, bool right_side, const long *ids, int count);
+
+private:
+    void count_side(long size, int sign);
+
+    void count_side_change(long old_size, long new_size);
+
+    atomic<long> live_count{0};
+    atomic<long> edge_ends_count{0};
+    atomic<long> empty_sides_count{0};
+    atomic<long> letters{0};
+    ChunkedArray<uint64_t, 10> live_bits;
+    ChunkedArray<SequenceRef> sequences;
+    ChunkedArray<int> sequence_lens;
+    ChunkedArray<Edges> left_edges_column;
+    ChunkedArray<Edges> right_edges_column;
+};
+
+inline bool NodeTable::contains(long id) const {
+    return id > 0 && id < sequences.capacity() &&
+           (__atomic_load_n(&live_bits[id >> 6], __ATOMIC_RELAXED) >> (id & 63) & 1);
+}
+
+inline SequenceRef &NodeTable::sequence(long id) {
+    return sequences[id];
+}
+
+inline int &NodeTable::sequence_len(long id) {
+    return sequence_lens[id];
+}
+
+inline Edges &NodeTable::left_edges(long id) {
+    return left_edges_column[id];
+}
+
+inline Edges &NodeTable::right_edges(long id) {
+    return right_edges_column[id];
+}
+
+inline void NodeTable::count_side_change(long old_size, long new_size) {
+    if (new_size != old_size)
+        edge_ends_count.fetch_add(new_size - old_size, memory_order_relaxed);
+    if ((old_size == 0) != (new_size == 0))
+        empty_sides_count.fetch_add(new_size == 0 ? 1 : -1, memory_order_relaxed);
+}
+
+inline void NodeTable::set_sequence_len(long id, int sequence_len) {
+    letters.fetch_add(sequence_len - sequence_lens[id], memory_order_relaxed);
+    sequence_lens[id] = sequence_len;
+}
+
+inline void NodeTable::insert_edge(long id, bool right_side, long neighbour_id) {
+    Edges &edges = right_side ? right_edges_column[id] : left_edges_column[id];
+    long old_size = edges.size();
+    edges.insert(neighbour_id);
+    count_side_change(old_size, edges.size());
+}
+
+inline void NodeTable::erase_edge(long id, bool right_side, long neighbour_id) {
+    Edges &edges = right_side ? right_edges_column[id] : left_edges_column[id];
+    long old_size = edges.size();
+    edges.erase(neighbour_id);
+    count_side_change(old_size, edges.size());
+}
+
+
+#endif //STARK_NODE_TABLE_H
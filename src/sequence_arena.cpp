@@ -0,0 +1,95 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#include <cstring>
+#include <utility>
+#include "sequence_arena.h"
+#include "utils/sequence_compare.h"
+
+SequenceArena::SequenceArena(size_t chunk_size) : chunk_size(chunk_size) {}
+
+SequenceArena::~SequenceArena() {
+    clear();
+}
+
+char *SequenceArena::allocate(size_t sequence_len) {
+    size_t needed_size = sequence_len + 1;
+    if (static_cast<size_t>(chunk_end - chunk_free) < needed_size) {
+        size_t new_chunk_size = needed_size > chunk_size ? needed_size : chunk_size;
+        // comparisons that run off the last sequence of a chunk may read a block past it
+        chunks.push_back({new char[new_chunk_size + COMPARE_BLOCK_SIZE], new_chunk_size});
+        chunk_free = chunks.back().data;
+        chunk_end = chunk_free + new_chunk_size;
+    }
+    char *sequence = chunk_free;
+    chunk_free += needed_size;
+    used_size += needed_size;
+    sequence[sequence_len] = 0;
+    return sequence;
+}
+
+char *SequenceArena::append(const char *sequence, size_t sequence_len) {
+    char *new_sequence = allocate(sequence_len);
+    memcpy(new_sequence, sequence, sequence_len);
+    return new_sequence;
+}
+
+SequenceRef SequenceArena::store(SequenceRef sequence, size_t sequence_len, bool pack) {
+    if (pack && !sequence.packed()) { // packed in one pass, the bytes are given back if a letter is not ACGT
+        size_t packed_size = (sequence_len + 3) / 4;
+        char *chunk_free_before = chunk_free;
+        auto *data = reinterpret_cast<uint8_t *>(allocate(packed_size));
+        const char *letters = sequence.letters();
+        int codes = 0;
+        for (size_t i = 0; i < sequence_len && codes >= 0; i += 4) {
+            codes = 0;
+            for (size_t j = i; j < i + 4 && j < sequence_len; ++j)
+                codes |= letter_code(letters[j]) << 2 * (j - i);
+            data[i / 4] = static_cast<uint8_t>(codes);
+        }
+        if (codes >= 0)
+            return SequenceRef::packed_at(data, 0);
+        if (reinterpret_cast<char *>(data) == chunk_free_before) {
+            chunk_free = reinterpret_cast<char *>(data);
+            used_size -= packed_size + 1;
+        }
+    } else if (pack) {
+        auto *data = reinterpret_cast<uint8_t *>(allocate((sequence_len + 3) / 4));
+        memset(data, 0, (sequence_len + 3) / 4);
+        for (size_t i = 0; i < sequence_len; ++i)
+            data[i / 4] |= static_cast<uint8_t>(letter_code(sequence[i]) << 2 * (i % 4));
+        return SequenceRef::packed_at(data, 0);
+    }
+    char *new_sequence = allocate(sequence_len);
+    sequence.copy_to(new_sequence, static_cast<long>(sequence_len));
+    return new_sequence;
+}
+
+size_t SequenceArena::size() const {
+    return used_size;
+}
+
+void SequenceArena::swap(SequenceArena &another_arena) {
+    std::swap(chunk_size, another_arena.chunk_size);
+    std::swap(used_size, another_arena.used_size);
+    std::swap(chunks, another_arena.chunks);
+    std::swap(chunk_free, another_arena.chunk_free);
+    std::swap(chunk_end, another_arena.chunk_end);
+}
+
+void SequenceArena::absorb(SequenceArena &another_arena) {
+    chunks.insert(chunks.end(), another_arena.chunks.begin(), another_arena.chunks.end());
+    used_size += another_arena.used_size;
+    another_arena.chunks.clear();
+    another_arena.used_size = 0;
+    another_arena.chunk_free = another_arena.chunk_end = nullptr;
+}
+
+void SequenceArena::clear() {
+    for (auto &chunk : chunks)
+        delete[] chunk.data;
+    chunks.clear();
+    used_size = 0;
+    chunk_free = chunk_end = nullptr;
+}
@@ -0,0 +1,67 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#include <cstddef>
+#include <vector>
+#include "sequence_ref.h"
+
+#ifndef STARK_SEQUENCE_ARENA_H
+#define STARK_SEQUENCE_ARENA_H
+
+
+/**
+ * A bump allocator for node sequences. Sequences are appended to large chunks and are only freed all together,
+ * when the arena is cleared or destroyed.
+ */
+class SequenceArena {
+public:
+    explicit SequenceArena(size_t chunk_size = 1UL << 26);
+
+    SequenceArena(const SequenceArena &) = delete;
+
+    SequenceArena &operator=(const SequenceArena &) = delete;
+
+    ~SequenceArena();
+
+    /**
+     * @return room for sequence_len letters followed by a zero byte, which is already written
+     */
+    char *allocate(size_t sequence_len);
+
+    char *append(const char *sequence, size_t sequence_len);
+
+    /**
+     * copies the letters of sequence, packed in 2 bits each if pack is set and they are all ACGT
+     */
+    SequenceRef store(SequenceRef sequence, size_t sequence_len, bool pack);
+
+    /**
+     * @return bytes taken by the allocated sequences
+     */
+    size_t size() const;
+
+    void swap(SequenceArena &another_arena);
+
+    /**
+     * takes over the sequences of another_arena, which is left empty
+     */
+    void absorb(SequenceArena &another_arena);
+
+    void clear();
+
+private:
+    struct Chunk {
+        char *data;
+        size_t size;
+    };
+
+    size_t chunk_size;
+    size_t used_size = 0;
+    std::vector<Chunk> chunks;
+    char *chunk_free = nullptr;
+    char *chunk_end = nullptr;
+};
+
+
+#endif //STARK_SEQUENCE_ARENA_H
@@ -0,0 +1,142 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "utils/sequence_compare.h"
+
+#ifndef STARK_SEQUENCE_REF_H
+#define STARK_SEQUENCE_REF_H
+
+#define PACKED_SEQUENCE_BIT         (static_cast<uintptr_t>(1) << 63)
+
+/**
+ * @return the 2-bit code of an ACGT letter, or -1 for any other letter, which can not be packed
+ */
+inline int letter_code(char letter) {
+    switch (letter) {
+        case 'A':
+            return 0;
+        case 'C':
+            return 1;
+        case 'G':
+            return 2;
+        case 'T':
+            return 3;
+        default:
+            return -1;
+    }
+}
+
+/**
+ * The letters of a sequence: either a char pointer, or the position of the first letter in 2-bit packed storage,
+ * which is the address of its byte times four plus its place in the byte, lowest bits first. Adding n to either kind
+ * moves n letters on, so nodes keep taking parts of the sequences of other nodes without copying them.
+ */
+class SequenceRef {
+public:
+    SequenceRef() = default;
+
+    SequenceRef(const char *letters) : bits(reinterpret_cast<uintptr_t>(letters)) {}
+
+    static SequenceRef packed_at(const uint8_t *data, long letter) {
+        SequenceRef sequence;
+        sequence.bits = ((reinterpret_cast<uintptr_t>(data) << 2) + letter) | PACKED_SEQUENCE_BIT;
+        return sequence;
+    }
+
+    bool packed() const {
+        return (bits & PACKED_SEQUENCE_BIT) != 0;
+    }
+
+    /**
+     * @return the letters of a sequence that is not packed
+     */
+    const char *letters() const {
+        return reinterpret_cast<const char *>(bits);
+    }
+
+    /**
+     * @return the packed position of a packed sequence
+     */
+    uintptr_t position() const {
+        return bits & ~PACKED_SEQUENCE_BIT;
+    }
+
+    char operator[](long i) const {
+        if (!packed())
+            return letters()[i];
+        uintptr_t letter_position = position() + i;
+        return "ACGT"[*reinterpret_cast<const uint8_t *>(letter_position >> 2) >> 2 * (letter_position & 3) & 3];
+    }
+
+    SequenceRef operator+(long n) const {
+        SequenceRef sequence;
+        sequence.bits = bits + n;
+        return sequence;
+    }
+
+    SequenceRef operator-(long n) const {
+        return *this + -n;
+    }
+
+    void copy_to(char *out, long len) const {
+        if (!packed())
+            memcpy(out, letters(), static_cast<size_t>(len));
+        else
+            for (long i = 0; i < len; ++i)
+                out[i] = (*this)[i];
+    }
+
+    std::string to_string(long len) const {
+        std::string text(static_cast<size_t>(len), ' ');
+        copy_to(&text[0], len);
+        return text;
+    }
+
+private:
+    uintptr_t bits = 0;
+};
+
+/**
+ * @return length of the longest common prefix of a[0, len) and b[0, len)
+ */
+inline int common_prefix_len(SequenceRef a, SequenceRef b, int len) {
+    if (!a.packed() && !b.packed())
+        return common_prefix_len(a.letters(), b.letters(), len);
+    if (a.packed() && b.packed())
+        return packed_common_prefix_len(a.position(), b.position(), len);
+    for (int i = 0; i < len; ++i)
+        if (a[i] != b[i])
+            return i;
+    return len;
+}
+
+/**
+ * @return length of the longest common suffix of the len letters before a_end and before b_end
+ */
+inline int common_suffix_len(SequenceRef a_end, SequenceRef b_end, int len) {
+    if (!a_end.packed() && !b_end.packed())
+        return common_suffix_len(a_end.letters(), b_end.letters(), len);
+    if (a_end.packed() && b_end.packed())
+        return packed_common_suffix_len(a_end.position(), b_end.position(), len);
+    for (int i = 0; i < len; ++i)
+        if (a_end[-i - 1] != b_end[-i - 1])
+            return i;
+    return len;
+}
+
+/**
+ * @return whether the len letters of letters already follow end, so the sequence that ends there can take them in
+ * place. Plain storage ends its data with a terminator the comparison stops at; packed storage has none, so it is
+ * never extended.
+ */
+inline bool extends_in_place(SequenceRef end, SequenceRef letters, int len) {
+    if (end.packed())
+        return len == 0;
+    return common_prefix_len(end, letters, len) == len;
+}
+
+#endif //STARK_SEQUENCE_REF_H
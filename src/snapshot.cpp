@@ -0,0 +1,230 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "snapshot.h"
+#include "node.h"
+#include "utils/logger.h"
+#include "utils/parallel.h"
+#include "utils/sequence_compare.h"
+
+using namespace std;
+
+#define SNAPSHOT_MAGIC              "STARKSNP"
+#define SNAPSHOT_VERSION            1
+#define SNAPSHOT_BUFFER_SIZE        (1UL << 24)
+#define SNAPSHOT_LETTERS_BLOCK      4096
+
+extern Logger *logger;
+
+/**
+ * The file starts with this header, followed by the live ids, their sequence lengths, left and right edge counts,
+ * zero bytes up to a multiple of eight, all of their edges (left then right for each node) and all of their sequences,
+ * each followed by a zero byte.
+ */
+struct SnapshotHeader {
+    char magic[8];
+    int version;
+    int k;
+    int phase;
+    int reserved;
+    long last_id;
+    long nodes_count;
+    long edges_count;
+    long sequences_size;
+};
+
+/**
+ * a buffered sequential writer that remembers whether any write failed
+ */
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(int fd) : fd(fd), buffer(SNAPSHOT_BUFFER_SIZE) {}
+
+    void write(const void *data, size_t len) {
+        if (buffer_size + len > buffer.size())
+            flush();
+        if (len > buffer.size())
+            write_all(static_cast<const char *>(data), len);
+        else {
+            memcpy(buffer.data() + buffer_size, data, len);
+            buffer_size += len;
+        }
+    }
+
+    /**
+     * writes the letters of a sequence, unpacking them if it is packed
+     */
+    void write_letters(SequenceRef sequence, long len) {
+        if (!sequence.packed()) {
+            write(sequence.letters(), static_cast<size_t>(len));
+            return;
+        }
+        char letters[SNAPSHOT_LETTERS_BLOCK];
+        for (long i = 0; i < len; i += SNAPSHOT_LETTERS_BLOCK) {
+            long letters_count = min(len - i, static_cast<long>(SNAPSHOT_LETTERS_BLOCK));
+            (sequence + i).copy_to(letters, letters_count);
+            write(letters, static_cast<size_t>(letters_count));
+        }
+    }
+
+    bool flush() {
+        write_all(buffer.data(), buffer_size);
+        buffer_size = 0;
+        return !failed;
+    }
+
+private:
+    void write_all(const char *data, size_t len) {
+        while (len > 0 && !failed) {
+            ssize_t written = ::write(fd, data, len);
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written <= 0)
+                failed = true;
+            else {
+                data += written;
+                len -= written;
+            }
+        }
+    }
+
+    int fd;
+    vector<char> buffer;
+    size_t buffer_size = 0;
+    bool failed = false;
+};
+
+static size_t counts_end(const SnapshotHeader &header) {
+    return sizeof(SnapshotHeader) + header.nodes_count * (sizeof(long) + 3 * sizeof(int));
+}
+
+static size_t edges_offset(const SnapshotHeader &header) {
+    return (counts_end(header) + sizeof(long) - 1) / sizeof(long) * sizeof(long);
+}
+
+bool save_snapshot(const char *file_name, int k, int phase) {
+    LOG_DEBUG("saving snapshot: %s", file_name);
+    string temporary_file_name = string(file_name) + ".tmp";
+    int fd = open(temporary_file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        LOG_ERROR("can not open file: %s", temporary_file_name.c_str());
+        return false;
+    }
+    SnapshotHeader header{};
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.k = k;
+    header.phase = phase;
+    header.last_id = Node::graph->last_id;
+    for (long i = 1; i <= Node::graph->last_id; ++i)
+        if (Node::graph->nodes.contains(i)) {
+            header.nodes_count++;
+            header.edges_count += Node::graph->nodes.left_edges(i).size() + Node::graph->nodes.right_edges(i).size();
+            header.sequences_size += Node::graph->nodes.sequence_len(i) + 1;
+        }
+    SnapshotWriter writer(fd);
+    writer.write(&header, sizeof(header));
+    for (long i = 1; i <= Node::graph->last_id; ++i)
+        if (Node::graph->nodes.contains(i))
+            writer.write(&i, sizeof(i));
+    for (long i = 1; i <= Node::graph->last_id; ++i)
+        if (Node::graph->nodes.contains(i))
+            writer.write(&Node::graph->nodes.sequence_len(i), sizeof(int));
+    for (int side = 0; side < 2; ++side)
+        for (long i = 1; i <= Node::graph->last_id; ++i)
+            if (Node::graph->nodes.contains(i)) {
+                auto edges_count = static_cast<int>((side == 0 ? Node::graph->nodes.left_edges(i)
+                                                               : Node::graph->nodes.right_edges(i)).size());
+                writer.write(&edges_count, sizeof(edges_count));
+            }
+    long zeros = 0;
+    writer.write(&zeros, edges_offset(header) - counts_end(header));
+    for (long i = 1; i <= Node::graph->last_id; ++i)
+        if (Node::graph->nodes.contains(i)) {
+            for (long left_neighbour_id : Node::graph->nodes.left_edges(i))
+                writer.write(&left_neighbour_id, sizeof(long));
+            for (long right_neighbour_id : Node::graph->nodes.right_edges(i))
+                writer.write(&right_neighbour_id, sizeof(long));
+        }
+    for (long i = 1; i <= Node::graph->last_id; ++i)
+        if (Node::graph->nodes.contains(i)) {
+            writer.write_letters(Node::graph->nodes.sequence(i), Node::graph->nodes.sequence_len(i));
+            writer.write(&zeros, 1);
+        }
+    bool written = writer.flush();
+    if (close(fd) != 0)
+        written = false;
+    if (written && rename(temporary_file_name.c_str(), file_name) != 0)
+        written = false;
+    if (!written) {
+        LOG_ERROR("can not write snapshot: %s", file_name);
+        unlink(temporary_file_name.c_str());
+        return false;
+    }
+    LOG_DEBUG("snapshot saved: %ld nodes, phase %d", header.nodes_count, phase);
+    return true;
+}
+
+bool load_snapshot(const char *file_name, int &k, int &phase, int threads_count) {
+    LOG_DEBUG("loading snapshot: %s", file_name);
+    auto *snapshot_file = new MappedFile(file_name, COMPARE_BLOCK_SIZE);
+    SnapshotHeader header{};
+    if (snapshot_file->is_open() && snapshot_file->size() >= sizeof(header))
+        memcpy(&header, snapshot_file->data(), sizeof(header));
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 || header.version != SNAPSHOT_VERSION ||
+        header.nodes_count < 0 || header.edges_count < 0 || header.sequences_size < 0 ||
+        snapshot_file->size() != edges_offset(header) + header.edges_count * sizeof(long) + header.sequences_size) {
+        LOG_FATAL("can not load snapshot: %s", file_name);
+        delete snapshot_file;
+        return false;
+    }
+    char *data = snapshot_file->data();
+    auto *ids = reinterpret_cast<long *>(data + sizeof(header));
+    auto *sequence_lens = reinterpret_cast<int *>(ids + header.nodes_count);
+    int *left_edges_counts = sequence_lens + header.nodes_count, *right_edges_counts =
+            left_edges_counts + header.nodes_count;
+    auto *edges = reinterpret_cast<long *>(data + edges_offset(header));
+    char *sequences_data = reinterpret_cast<char *>(edges + header.edges_count);
+    vector<long> node_edges_offsets(static_cast<unsigned long>(header.nodes_count + 1), 0);
+    vector<long> node_sequence_offsets(static_cast<unsigned long>(header.nodes_count + 1), 0);
+    bool valid = true;
+    for (long j = 0; j < header.nodes_count; ++j) {
+        if (ids[j] <= 0 || ids[j] > header.last_id || sequence_lens[j] < 0 || left_edges_counts[j] < 0 ||
+            right_edges_counts[j] < 0)
+            valid = false;
+        node_edges_offsets[j + 1] = node_edges_offsets[j] + left_edges_counts[j] + right_edges_counts[j];
+        node_sequence_offsets[j + 1] = node_sequence_offsets[j] + sequence_lens[j] + 1;
+    }
+    if (!valid || node_edges_offsets.back() != header.edges_count ||
+        node_sequence_offsets.back() != header.sequences_size) {
+        LOG_FATAL("can not load snapshot: %s", file_name);
+        delete snapshot_file;
+        return false;
+    }
+
+    Node::graph->nodes.clear();
+    Node::graph->last_id = header.last_id;
+    Node::graph->nodes.reserve(Node::graph->last_id);
+    parallel_for(0, header.nodes_count, threads_count, [&](long j) {
+        long id = ids[j];
+        Node::graph->nodes.add(id, sequences_data + node_sequence_offsets[j], sequence_lens[j]);
+        Node::graph->nodes.assign_edges(id, false, edges + node_edges_offsets[j], left_edges_counts[j]);
+        Node::graph->nodes.assign_edges(id, true, edges + node_edges_offsets[j] + left_edges_counts[j],
+                                        right_edges_counts[j]);
+    });
+    delete Node::graph->input_file;
+    Node::graph->input_file = snapshot_file;
+    k = header.k;
+    phase = header.phase;
+    LOG_DEBUG("snapshot loaded: %ld nodes, phase %d", header.nodes_count, phase);
+    return true;
+}
@@ -0,0 +1,23 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#ifndef STARK_SNAPSHOT_H
+#define STARK_SNAPSHOT_H
+
+/**
+ * writes Node::graph, with their edges and sequences, to a binary snapshot file together with k and the number of the
+ * last finished phase. The file is written next to file_name and renamed over it, so an older snapshot survives a
+ * crash while saving.
+ * @return false if the file could not be written
+ */
+bool save_snapshot(const char *file_name, int k, int phase);
+
+/**
+ * replaces Node::graph with the graph of a snapshot file. The file is mapped as Node::graph->input_file and node
+ * sequences point into it, so loading only rebuilds the edge sets, on threads_count threads.
+ * @return false if the file could not be read or is not a snapshot
+ */
+bool load_snapshot(const char *file_name, int &k, int &phase, int threads_count = 1);
+
+#endif //STARK_SNAPSHOT_H
@@ -0,0 +1,63 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#include <vector>
+
+#ifndef CHUNKED_ARRAY_H
+#define CHUNKED_ARRAY_H
+
+/**
+ * An index-addressed array that grows in fixed-size chunks. Elements never move once allocated, so references to
+ * them stay valid while the array grows, and each chunk is a contiguous block for sequential scans.
+ */
+template<typename T, int CHUNK_BITS = 16>
+class ChunkedArray {
+public:
+    static const long CHUNK_SIZE = 1L << CHUNK_BITS;
+
+    ChunkedArray() = default;
+
+    ChunkedArray(const ChunkedArray &) = delete;
+
+    ChunkedArray &operator=(const ChunkedArray &) = delete;
+
+    ~ChunkedArray() {
+        clear();
+    }
+
+    T &operator[](long index) {
+        return chunks[index >> CHUNK_BITS][index & (CHUNK_SIZE - 1)];
+    }
+
+    const T &operator[](long index) const {
+        return chunks[index >> CHUNK_BITS][index & (CHUNK_SIZE - 1)];
+    }
+
+    /**
+     * makes [0, index] addressable; new elements are value-initialized
+     */
+    void ensure(long index) {
+        while (static_cast<unsigned long>(index >> CHUNK_BITS) >= chunks.size())
+            chunks.push_back(new T[CHUNK_SIZE]());
+    }
+
+    long capacity() const {
+        return static_cast<long>(chunks.size()) * CHUNK_SIZE;
+    }
+
+    void swap(ChunkedArray &another_array) {
+        chunks.swap(another_array.chunks);
+    }
+
+    void clear() {
+        for (T *chunk : chunks)
+            delete[] chunk;
+        chunks.clear();
+    }
+
+private:
+    std::vector<T *> chunks;
+};
+
+#endif //CHUNKED_ARRAY_H
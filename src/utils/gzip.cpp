@@ -0,0 +1,246 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#include "gzip.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "parallel.h"
+
+#define GZIP_HEADER_SIZE            10
+#define GZIP_FOOTER_SIZE            8
+#define BGZF_HEADER_SIZE            18
+#define ZLIB_MAX_CHUNK              (1UL << 30)
+
+const char BGZF_EOF[BGZF_EOF_SIZE] = {'\x1f', '\x8b', '\x08', '\x04', '\x00', '\x00', '\x00', '\x00', '\x00', '\xff',
+                                      '\x06', '\x00', '\x42', '\x43', '\x02', '\x00', '\x1b', '\x00', '\x03', '\x00',
+                                      '\x00', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00'};
+
+static uint32_t read_le(const unsigned char *data, int bytes) {
+    uint32_t value = 0;
+    for (int i = bytes - 1; i >= 0; --i)
+        value = value << 8 | data[i];
+    return value;
+}
+
+static void write_le(char *out, uint32_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i, value >>= 8)
+        out[i] = static_cast<char>(value & 0xff);
+}
+
+bool is_gzip(const char *data, size_t size) {
+    return size >= 2 && static_cast<unsigned char>(data[0]) == 0x1f && static_cast<unsigned char>(data[1]) == 0x8b;
+}
+
+/**
+ * splits data into its BGZF blocks
+ * @return false if some member of data is not a BGZF block
+ */
+static bool find_bgzf_blocks(const char *data, size_t size, std::vector<BgzfBlock> &blocks, size_t &output_size) {
+    output_size = 0;
+    for (size_t position = 0; position < size;) {
+        auto *block = reinterpret_cast<const unsigned char *>(data + position);
+        if (size - position < BGZF_HEADER_SIZE + GZIP_FOOTER_SIZE || !is_gzip(data + position, size - position) ||
+            block[2] != Z_DEFLATED || block[3] != 4)
+            return false;
+        size_t extra_end = 12 + read_le(block + 10, 2), block_size = 0;
+        for (size_t field = 12; field + 4 <= extra_end; field += 4 + read_le(block + field + 2, 2))
+            if (block[field] == 'B' && block[field + 1] == 'C' && read_le(block + field + 2, 2) == 2)
+                block_size = read_le(block + field + 4, 2) + 1UL;
+        if (block_size < extra_end + GZIP_FOOTER_SIZE || block_size > size - position)
+            return false;
+        blocks.push_back({position + extra_end, block_size - extra_end - GZIP_FOOTER_SIZE, output_size,
+                          read_le(block + block_size - 4, 4), read_le(block + block_size - 8, 4)});
+        output_size += blocks.back().output_size;
+        position += block_size;
+    }
+    return true;
+}
+
+static char *map_output(size_t size, size_t padding, size_t &mapped_size) {
+    auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    mapped_size = (size + padding + page_size - 1) / page_size * page_size;
+    void *mapped = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return mapped == MAP_FAILED ? nullptr : static_cast<char *>(mapped);
+}
+
+/**
+ * decompresses blocks_count blocks, the first of them to output and the others after it
+ */
+static bool bgzf_decompress(const char *data, const BgzfBlock *blocks, long blocks_count, int threads_count,
+                            char *output) {
+    std::atomic<bool> valid{true};
+    size_t first_offset = blocks_count > 0 ? blocks[0].output_offset : 0;
+    parallel_ranges(0, blocks_count, threads_count,
+                    [&](int, long range_begin, long range_end) {
+                        z_stream stream{};
+                        if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+                            valid = false;
+                            return;
+                        }
+                        for (long i = range_begin; i < range_end && valid; ++i) {
+                            const BgzfBlock &block = blocks[i];
+                            char *block_output = output + (block.output_offset - first_offset);
+                            inflateReset(&stream);
+                            stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data + block.data_offset));
+                            stream.avail_in = static_cast<uInt>(block.data_size);
+                            stream.next_out = reinterpret_cast<Bytef *>(block_output);
+                            stream.avail_out = static_cast<uInt>(block.output_size);
+                            if (inflate(&stream, Z_FINISH) != Z_STREAM_END || stream.avail_out != 0 ||
+                                crc32(0, reinterpret_cast<Bytef *>(block_output),
+                                      static_cast<uInt>(block.output_size)) != block.crc)
+                                valid = false;
+                        }
+                        inflateEnd(&stream);
+                    });
+    return valid;
+}
+
+/**
+ * decompresses any gzip members one after another, growing output as needed
+ */
+static bool stream_decompress(const char *data, size_t size, size_t padding, char *&output, size_t &output_size,
+                              size_t &mapped_size) {
+    GzipReader reader(data, size);
+    output_size = 0;
+    while (!reader.at_end()) {
+        if (output_size + padding == mapped_size) {
+            void *grown = mremap(output, mapped_size, mapped_size * 2, MREMAP_MAYMOVE);
+            if (grown == MAP_FAILED)
+                return false;
+            output = static_cast<char *>(grown);
+            mapped_size *= 2;
+        }
+        output_size += reader.read(output + output_size, mapped_size - padding - output_size);
+    }
+    return !reader.failed();
+}
+
+bool gzip_decompress(const char *data, size_t size, size_t padding, int threads_count, char *&output,
+                     size_t &output_size, size_t &mapped_size) {
+    std::vector<BgzfBlock> blocks;
+    bool bgzf = find_bgzf_blocks(data, size, blocks, output_size);
+    if (!bgzf) // the size of the last member is only a hint for the whole output
+        output_size = std::max(size >= GZIP_HEADER_SIZE + GZIP_FOOTER_SIZE
+                               ? read_le(reinterpret_cast<const unsigned char *>(data + size - 4), 4) : 0UL, size * 2);
+    output = map_output(output_size, padding, mapped_size);
+    if (!output)
+        return false;
+    bool valid = bgzf ? bgzf_decompress(data, blocks.data(), static_cast<long>(blocks.size()), threads_count, output)
+                      : stream_decompress(data, size, padding, output, output_size, mapped_size);
+    if (!valid) {
+        munmap(output, mapped_size);
+        output = nullptr;
+    }
+    return valid;
+}
+
+GzipReader::GzipReader(const char *data, size_t size, int threads_count) : data(data), size(size),
+                                                                         threads_count(threads_count) {
+    size_t output_size;
+    bgzf = find_bgzf_blocks(data, size, blocks, output_size);
+    if (!bgzf) {
+        blocks.clear();
+        valid = inflateInit2(&stream, MAX_WBITS + 16) == Z_OK;
+    }
+}
+
+GzipReader::~GzipReader() {
+    if (!bgzf)
+        inflateEnd(&stream);
+}
+
+size_t GzipReader::read(char *out, size_t len) {
+    if (bgzf) {
+        size_t blocks_end = position, written = 0;
+        for (; blocks_end < blocks.size() && written + blocks[blocks_end].output_size <= len; ++blocks_end)
+            written += blocks[blocks_end].output_size;
+        if (blocks_end == position) {
+            if (position < blocks.size() && len >= BGZF_MAX_BLOCK_SIZE)
+                valid = false; // the block claims more than BGZF allows
+            return 0;
+        }
+        if (!bgzf_decompress(data, blocks.data() + position, static_cast<long>(blocks_end - position),
+                             threads_count, out))
+            valid = false;
+        position = blocks_end;
+        return valid ? written : 0;
+    }
+    size_t written = 0;
+    while (written < len && !at_end()) {
+        if (member_ended) {
+            inflateReset(&stream); // another member follows
+            member_ended = false;
+        }
+        auto avail_in = static_cast<uInt>(std::min(size - position, ZLIB_MAX_CHUNK));
+        auto avail_out = static_cast<uInt>(std::min(len - written, ZLIB_MAX_CHUNK));
+        stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data + position));
+        stream.avail_in = avail_in;
+        stream.next_out = reinterpret_cast<Bytef *>(out + written);
+        stream.avail_out = avail_out;
+        int result = inflate(&stream, Z_NO_FLUSH);
+        position += avail_in - stream.avail_in;
+        written += avail_out - stream.avail_out;
+        if (result == Z_STREAM_END)
+            member_ended = true;
+        else if (result != Z_OK && !(result == Z_BUF_ERROR && stream.avail_out == 0))
+            valid = false;
+    }
+    return written;
+}
+
+bool GzipReader::at_end() const {
+    return !valid || (bgzf ? position == blocks.size() : member_ended && position == size);
+}
+
+bool GzipReader::failed() const {
+    return !valid;
+}
+
+void GzipReader::rewind() {
+    position = 0;
+    if (!bgzf) {
+        valid = inflateReset(&stream) == Z_OK;
+        member_ended = false;
+    } else
+        valid = true;
+}
+
+BgzfCompressor::BgzfCompressor(int level) {
+    deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+}
+
+BgzfCompressor::~BgzfCompressor() {
+    deflateEnd(&stream);
+}
+
+size_t BgzfCompressor::bound(size_t len) {
+    size_t blocks_count = (len + BGZF_BLOCK_DATA_SIZE - 1) / BGZF_BLOCK_DATA_SIZE;
+    return blocks_count * (BGZF_HEADER_SIZE + compressBound(BGZF_BLOCK_DATA_SIZE) + GZIP_FOOTER_SIZE);
+}
+
+size_t BgzfCompressor::compress(const char *data, size_t len, char *out) {
+    char *out_begin = out;
+    for (size_t offset = 0; offset < len; offset += BGZF_BLOCK_DATA_SIZE) {
+        auto block_data_size = static_cast<uInt>(std::min(len - offset, static_cast<size_t>(BGZF_BLOCK_DATA_SIZE)));
+        memcpy(out, BGZF_EOF, BGZF_HEADER_SIZE - 2);
+        deflateReset(&stream);
+        stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data + offset));
+        stream.avail_in = block_data_size;
+        stream.next_out = reinterpret_cast<Bytef *>(out + BGZF_HEADER_SIZE);
+        stream.avail_out = static_cast<uInt>(compressBound(BGZF_BLOCK_DATA_SIZE));
+        deflate(&stream, Z_FINISH);
+        auto block_size = static_cast<uint32_t>(reinterpret_cast<char *>(stream.next_out) - out + GZIP_FOOTER_SIZE);
+        write_le(out + BGZF_HEADER_SIZE - 2, block_size - 1, 2);
+        char *footer = out + block_size - GZIP_FOOTER_SIZE;
+        write_le(footer, static_cast<uint32_t>(crc32(0, stream.next_in - block_data_size, block_data_size)), 4);
+        write_le(footer + 4, block_data_size, 4);
+        out += block_size;
+    }
+    return out - out_begin;
+}
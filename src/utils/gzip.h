@@ -0,0 +1,117 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <zlib.h>
+
+#ifndef GZIP_H
+#define GZIP_H
+
+#define BGZF_BLOCK_DATA_SIZE        65280
+#define BGZF_EOF_SIZE               28
+#define BGZF_MAX_BLOCK_SIZE         65536 // the most bytes a BGZF block decompresses to
+
+/**
+ * the empty block that ends a BGZF file
+ */
+extern const char BGZF_EOF[BGZF_EOF_SIZE];
+
+/**
+ * where the deflate data of a BGZF block lies in the file and where it goes in the decompressed content
+ */
+struct BgzfBlock {
+    size_t data_offset;
+    size_t data_size;
+    size_t output_offset;
+    size_t output_size;
+    uint32_t crc;
+};
+
+bool is_gzip(const char *data, size_t size);
+
+/**
+ * decompresses the gzip members in [data, data + size) into a new anonymous mapping, followed by at least padding zero
+ * bytes. BGZF files are decompressed block by block on threads_count threads, other files by one thread.
+ * @param output gets the mapping, which the caller releases with munmap(output, mapped_size)
+ * @return false if the data is not valid gzip
+ */
+bool gzip_decompress(const char *data, size_t size, size_t padding, int threads_count, char *&output,
+                     size_t &output_size, size_t &mapped_size);
+
+/**
+ * Decompresses the gzip members in [data, data + size) a piece at a time, so that only the pieces asked for are held
+ * in memory. BGZF blocks are decompressed whole, on threads_count threads, other files by one thread.
+ */
+class GzipReader {
+public:
+    GzipReader(const char *data, size_t size, int threads_count = 1);
+
+    GzipReader(const GzipReader &) = delete;
+
+    GzipReader &operator=(const GzipReader &) = delete;
+
+    ~GzipReader();
+
+    /**
+     * decompresses the next bytes of the data to out, at most len of them and at least one BGZF block if len is at
+     * least BGZF_MAX_BLOCK_SIZE
+     * @return the number of bytes written, 0 at the end of the data or if it is not valid gzip
+     */
+    size_t read(char *out, size_t len);
+
+    /**
+     * @return whether all the data has been read or found invalid
+     */
+    bool at_end() const;
+
+    bool failed() const;
+
+    /**
+     * starts reading from the beginning of the data again
+     */
+    void rewind();
+
+private:
+    const char *data;
+    size_t size;
+    int threads_count;
+    bool bgzf;
+    std::vector<BgzfBlock> blocks;
+    size_t position = 0; // the next block for BGZF, the next input byte otherwise
+    bool valid = true;
+    z_stream stream{};
+    bool member_ended = false;
+};
+
+/**
+ * Compresses data into BGZF blocks, which any gzip reader can decompress and which can be concatenated.
+ */
+class BgzfCompressor {
+public:
+    explicit BgzfCompressor(int level = Z_DEFAULT_COMPRESSION);
+
+    BgzfCompressor(const BgzfCompressor &) = delete;
+
+    BgzfCompressor &operator=(const BgzfCompressor &) = delete;
+
+    ~BgzfCompressor();
+
+    /**
+     * @return the most bytes compress() can write for len bytes of data
+     */
+    static size_t bound(size_t len);
+
+    /**
+     * writes [data, data + len) as BGZF blocks to out, without the end of file block
+     * @return the number of bytes written
+     */
+    size_t compress(const char *data, size_t len, char *out);
+
+private:
+    z_stream stream{};
+};
+
+#endif //GZIP_H
@@ -5,21 +5,28 @@
 #include "logger.h"
 #include <iostream>
 #include <cstdarg>
+#include <cstdlib>
 #include <cstring>
 
 #define LOGGER_FUNCTION(FUNC_NAME, LOG_LEVEL)       \
 void Logger::FUNC_NAME(const char *format, ...) {\
-    va_list args;\
-    va_start(args, format);\
     if ((LOG_LEVEL) > this->log_level)\
         return;\
-    log(formatString(format, args), LOG_LEVEL);\
+    va_list args;\
+    va_start(args, format);\
+    log(LOG_LEVEL, format, args);\
     va_end(args);\
 }\
 
+#define LOGGER_IDLE_SLEEP_MS 1
+
 Logger *logger;
 
-Logger::Logger(int log_level) : log_level(static_cast<LogLevel>(log_level)) {}
+Logger::Logger(int log_level) : log_level(static_cast<LogLevel>(log_level)), stream(&std::cout) {}
+
+Logger::~Logger() {
+    stop_async();
+}
 
 LOGGER_FUNCTION(debugl4, DEBUGL4)
 
@@ -42,12 +49,117 @@ using namespace std;
 void Logger::log(const string &s, LogLevel level) {
     if (level > this->log_level)
         return;
-    time_t ctt = time(nullptr);
-    char *time = asctime(localtime(&ctt));
-    time[strlen(time) - 1] = '\0';
-    mtx.lock();
-    cout << time << ": " << s << "\n";
-    mtx.unlock();
+    print(level, "%s", s.c_str());
+}
+
+void Logger::print(LogLevel level, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    log(level, format, args);
+    va_end(args);
+}
+
+void Logger::log(LogLevel level, const char *format, va_list args) {
+    if (!draining.load(memory_order_acquire)) {
+        char text[FORMAT_LENGTH];
+        text[0] = 0;
+        vsnprintf(text, FORMAT_LENGTH, format, args);
+        mtx.lock();
+        write(time(nullptr), text);
+        mtx.unlock();
+        return;
+    }
+    unsigned long position = claim();
+    Message &message = ring[position & (LOGGER_RING_SIZE - 1)];
+    message.text[0] = 0;
+    vsnprintf(message.text, FORMAT_LENGTH, format, args);
+    message.time = time(nullptr);
+    message.sequence.store(position + 1, memory_order_release);
+    if (level == FATAL)
+        flush();
+}
+
+/**
+ * takes the next free position of the ring, waiting while the ring is full
+ */
+unsigned long Logger::claim() {
+    unsigned long position = ring_head.load(memory_order_relaxed);
+    while (true) {
+        unsigned long sequence = ring[position & (LOGGER_RING_SIZE - 1)].sequence.load(memory_order_acquire);
+        auto difference = static_cast<long>(sequence - position);
+        if (difference == 0) {
+            if (ring_head.compare_exchange_weak(position, position + 1, memory_order_relaxed))
+                return position;
+        } else {
+            if (difference < 0)
+                this_thread::yield();
+            position = ring_head.load(memory_order_relaxed);
+        }
+    }
+}
+
+void Logger::write(time_t time, const char *text) {
+    if (time != last_time || !last_time_str[0]) {
+        char *time_str = asctime(localtime(&time));
+        time_str[strlen(time_str) - 1] = '\0';
+        strncpy(last_time_str, time_str, sizeof(last_time_str) - 1);
+        last_time = time;
+    }
+    *stream << last_time_str << ": " << text << "\n";
+}
+
+void Logger::drain() {
+    while (true) {
+        bool running = draining.load(memory_order_acquire);
+        unsigned long position = ring_tail.load(memory_order_relaxed);
+        Message &message = ring[position & (LOGGER_RING_SIZE - 1)];
+        if (message.sequence.load(memory_order_acquire) == position + 1) {
+            write(message.time, message.text);
+            message.sequence.store(position + LOGGER_RING_SIZE, memory_order_release);
+            ring_tail.store(position + 1, memory_order_release);
+        } else if (!running) {
+            stream->flush();
+            return;
+        } else {
+            stream->flush();
+            this_thread::sleep_for(chrono::milliseconds(LOGGER_IDLE_SLEEP_MS));
+        }
+    }
+}
+
+void Logger::start_async() {
+    if (ring)
+        return;
+    ring.reset(new Message[LOGGER_RING_SIZE]);
+    for (unsigned long i = 0; i < LOGGER_RING_SIZE; ++i)
+        ring[i].sequence.store(i, memory_order_relaxed);
+    draining.store(true, memory_order_release);
+    drainer = thread(&Logger::drain, this);
+    atexit(stop_async_at_exit);
+}
+
+void Logger::flush() {
+    if (!draining.load(memory_order_acquire)) {
+        mtx.lock();
+        stream->flush();
+        mtx.unlock();
+        return;
+    }
+    unsigned long head = ring_head.load(memory_order_acquire);
+    while (ring_tail.load(memory_order_acquire) < head)
+        this_thread::yield();
+}
+
+void Logger::stop_async() {
+    if (!drainer.joinable())
+        return;
+    draining.store(false, memory_order_release);
+    drainer.join();
+}
+
+void Logger::stop_async_at_exit() {
+    if (logger)
+        logger->stop_async();
 }
 
 string Logger::formatString(const char *const format, va_list args) {
@@ -64,4 +176,3 @@ string Logger::formatString(const char *const format, ...) {
     va_end(args);
     return s;
 }
-
@@ -2,13 +2,39 @@
  * @author Hassan Nikaein
  */
 
+#include <atomic>
+#include <cstdarg>
+#include <ctime>
+#include <memory>
 #include <string>
 #include <mutex>
+#include <ostream>
+#include <thread>
 
 #ifndef LOGGER_H
 #define LOGGER_H
 
 #define FORMAT_LENGTH 1000
+#define LOGGER_RING_SIZE 1024 // a power of two
+
+// the most verbose level compiled in, the log macros of more verbose levels compile to nothing
+#ifndef STARK_LOG_LEVEL
+#define STARK_LOG_LEVEL 1000
+#endif
+
+#define LOG_AT(LEVEL, FUNC_NAME, ...) do {\
+    if ((LEVEL) <= STARK_LOG_LEVEL && (LEVEL) <= logger->log_level)\
+        logger->FUNC_NAME(__VA_ARGS__);\
+} while (0)
+
+#define LOG_DEBUGL4(...) LOG_AT(Logger::DEBUGL4, debugl4, __VA_ARGS__)
+#define LOG_DEBUGL3(...) LOG_AT(Logger::DEBUGL3, debugl3, __VA_ARGS__)
+#define LOG_DEBUGL2(...) LOG_AT(Logger::DEBUGL2, debugl2, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT(Logger::DEBUG, debug, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(Logger::INFO, info, __VA_ARGS__)
+#define LOG_WARN(...) LOG_AT(Logger::WARN, warn, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(Logger::ERROR, error, __VA_ARGS__)
+#define LOG_FATAL(...) LOG_AT(Logger::FATAL, fatal, __VA_ARGS__)
 
 class Logger {
 public:
@@ -18,6 +44,8 @@ public:
 
     explicit Logger(int log_level);
 
+    ~Logger();
+
     void debugl4(const char *format, ...);
 
     void debugl3(const char *format, ...);
@@ -36,13 +64,53 @@ public:
 
     void log(const std::string &s, LogLevel level);
 
+    /**
+     * from now on, messages are queued in a ring buffer and written to stream by a background thread; they are all
+     * written before the program exits
+     */
+    void start_async();
+
+    /**
+     * waits until all queued messages are written to stream
+     */
+    void flush();
+
     static std::string formatString(const char *format, ...);
 
     LogLevel log_level = OFF;
+    std::ostream *stream;
 private:
+    struct Message {
+        std::atomic<unsigned long> sequence;
+        time_t time;
+        char text[FORMAT_LENGTH];
+    };
+
+    void log(LogLevel level, const char *format, va_list args);
+
+    void print(LogLevel level, const char *format, ...);
+
+    unsigned long claim();
+
+    void write(time_t time, const char *text);
+
+    void drain();
+
+    void stop_async();
+
+    static void stop_async_at_exit();
+
     std::mutex mtx;
+    std::unique_ptr<Message[]> ring;
+    std::atomic<unsigned long> ring_head{0}, ring_tail{0};
+    std::atomic<bool> draining{false};
+    std::thread drainer;
+    time_t last_time = 0;
+    char last_time_str[32] = "";
 
     static std::string formatString(const char *format, va_list args);
 };
 
-#endif //LOGGER_H
\ No newline at end of file
+extern Logger *logger;
+
+#endif //LOGGER_H
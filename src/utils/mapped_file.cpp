@@ -0,0 +1,68 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#include "mapped_file.h"
+#include "gzip.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const char *file_name, size_t padding, int threads_count, bool decompress) {
+    int fd = open(file_name, O_RDONLY);
+    if (fd < 0)
+        return;
+    struct stat file_stat{};
+    if (fstat(fd, &file_stat) != 0) {
+        close(fd);
+        return;
+    }
+    data_size = static_cast<size_t>(file_stat.st_size);
+    auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    mapped_size = (data_size + padding + page_size - 1) / page_size * page_size;
+    // reserve the padding after the file with zero pages, then lay the file over the start of the reservation
+    void *reserved = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (reserved == MAP_FAILED) {
+        close(fd);
+        return;
+    }
+    if (data_size > 0) {
+        void *file_data = mmap(reserved, data_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0);
+        if (file_data == MAP_FAILED) {
+            munmap(reserved, mapped_size);
+            close(fd);
+            return;
+        }
+        madvise(file_data, data_size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+    mapped_data = static_cast<char *>(reserved);
+    if (decompress && is_gzip(mapped_data, data_size)) {
+        char *decompressed_data;
+        size_t decompressed_size, decompressed_mapped_size;
+        bool decompressed = gzip_decompress(mapped_data, data_size, padding, threads_count, decompressed_data,
+                                            decompressed_size, decompressed_mapped_size);
+        munmap(mapped_data, mapped_size);
+        mapped_data = decompressed ? decompressed_data : nullptr;
+        data_size = decompressed ? decompressed_size : 0;
+        mapped_size = decompressed ? decompressed_mapped_size : 0;
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (mapped_data)
+        munmap(mapped_data, mapped_size);
+}
+
+bool MappedFile::is_open() const {
+    return mapped_data != nullptr;
+}
+
+char *MappedFile::data() const {
+    return mapped_data;
+}
+
+size_t MappedFile::size() const {
+    return data_size;
+}
@@ -0,0 +1,38 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#include <cstddef>
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+/**
+ * A private, writable memory mapping of a whole file. The padding bytes right after the end of the file are always
+ * mapped and zero, so scanners can run past the data without checking bounds. A gzip or BGZF file is decompressed
+ * into memory, on threads_count threads for BGZF, and the mapping holds its decompressed content instead, unless
+ * decompress is false.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const char *file_name, size_t padding = 1, int threads_count = 1, bool decompress = true);
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile();
+
+    bool is_open() const;
+
+    char *data() const;
+
+    size_t size() const;
+
+private:
+    char *mapped_data = nullptr;
+    size_t data_size = 0;
+    size_t mapped_size = 0;
+};
+
+#endif //MAPPED_FILE_H
@@ -0,0 +1,51 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#include <thread>
+#include <vector>
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+/**
+ * calls function(thread_index) on threads_count threads and waits for all of them; a single call runs on the caller
+ */
+template<typename Function>
+void run_on_threads(int threads_count, Function function) {
+    if (threads_count <= 1) {
+        function(0);
+        return;
+    }
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threads_count; ++i)
+        threads.emplace_back(function, i);
+    for (auto &thread : threads)
+        thread.join();
+}
+
+/**
+ * calls function(thread_index, range_begin, range_end) on threads_count threads, for contiguous parts of [begin, end)
+ */
+template<typename Function>
+void parallel_ranges(long begin, long end, int threads_count, Function function) {
+    if (threads_count < 1)
+        threads_count = 1;
+    run_on_threads(threads_count, [&](int thread_index) {
+        function(thread_index, begin + (end - begin) * thread_index / threads_count,
+                 begin + (end - begin) * (thread_index + 1) / threads_count);
+    });
+}
+
+/**
+ * calls function(i) for every i in [begin, end), giving each of threads_count threads one contiguous range
+ */
+template<typename Function>
+void parallel_for(long begin, long end, int threads_count, Function function) {
+    parallel_ranges(begin, end, threads_count, [&](int, long range_begin, long range_end) {
+        for (long i = range_begin; i < range_end; ++i)
+            function(i);
+    });
+}
+
+#endif //PARALLEL_H
@@ -0,0 +1,127 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#include <cstdint>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#ifndef SEQUENCE_COMPARE_H
+#define SEQUENCE_COMPARE_H
+
+/**
+ * The kernels load whole blocks, so they may read up to COMPARE_BLOCK_SIZE - 1 bytes past the first mismatch. Buffers
+ * that a comparison can run off (because it is stopped by their terminator) need that many readable bytes after it.
+ */
+#define COMPARE_BLOCK_SIZE          16
+
+/**
+ * @return length of the longest common prefix of a[0, len) and b[0, len)
+ */
+inline int common_prefix_len(const char *a, const char *b, int len) {
+    int i = 0;
+#ifdef __SSE2__
+    for (; i + 16 <= len; i += 16) {
+        __m128i a_block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        __m128i b_block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        auto mismatches = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(a_block, b_block))) ^ 0xFFFFu;
+        if (mismatches)
+            return i + __builtin_ctz(mismatches);
+    }
+#endif
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    for (; i + 8 <= len; i += 8) {
+        uint64_t a_word, b_word;
+        memcpy(&a_word, a + i, 8);
+        memcpy(&b_word, b + i, 8);
+        if (a_word != b_word)
+            return i + (__builtin_ctzll(a_word ^ b_word) >> 3);
+    }
+#endif
+    for (; i < len; ++i)
+        if (a[i] != b[i])
+            return i;
+    return len;
+}
+
+/**
+ * @return length of the longest common suffix of [a_end - len, a_end) and [b_end - len, b_end)
+ */
+inline int common_suffix_len(const char *a_end, const char *b_end, int len) {
+    int i = 0;
+#ifdef __SSE2__
+    for (; i + 16 <= len; i += 16) {
+        __m128i a_block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a_end - i - 16));
+        __m128i b_block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b_end - i - 16));
+        auto mismatches = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(a_block, b_block))) ^ 0xFFFFu;
+        if (mismatches)
+            return i + __builtin_clz(mismatches) - 16;
+    }
+#endif
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    for (; i + 8 <= len; i += 8) {
+        uint64_t a_word, b_word;
+        memcpy(&a_word, a_end - i - 8, 8);
+        memcpy(&b_word, b_end - i - 8, 8);
+        if (a_word != b_word)
+            return i + (__builtin_clzll(a_word ^ b_word) >> 3);
+    }
+#endif
+    for (; i < len; ++i)
+        if (a_end[-i - 1] != b_end[-i - 1])
+            return i;
+    return len;
+}
+
+/**
+ * 2-bit packed letters are compared PACKED_WORD_LETTERS at a time, loaded from a word at the byte of the first of them
+ */
+#define PACKED_WORD_LETTERS         28
+
+/**
+ * @return letters_count, at most PACKED_WORD_LETTERS, letters of 2-bit packed storage from letter position on, the
+ * first in the lowest bits; position is the address of a byte times four plus the letter in it
+ */
+inline uint64_t load_packed_letters(uintptr_t position, int letters_count) {
+    uint64_t word = 0;
+    auto *data = reinterpret_cast<const uint8_t *>(position >> 2);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(&word, data, 8);
+#else
+    for (int i = 0; i < 8; ++i)
+        word |= static_cast<uint64_t>(data[i]) << 8 * i;
+#endif
+    return word >> 2 * (position & 3) & ((1ULL << 2 * letters_count) - 1);
+}
+
+/**
+ * @return length of the longest common prefix of the len packed letters from positions a and b
+ */
+inline int packed_common_prefix_len(uintptr_t a, uintptr_t b, int len) {
+    for (int i = 0; i < len; i += PACKED_WORD_LETTERS) {
+        int letters_count = len - i < PACKED_WORD_LETTERS ? len - i : PACKED_WORD_LETTERS;
+        uint64_t mismatches = load_packed_letters(a + i, letters_count) ^ load_packed_letters(b + i, letters_count);
+        if (mismatches)
+            return i + (__builtin_ctzll(mismatches) >> 1);
+    }
+    return len;
+}
+
+/**
+ * @return length of the longest common suffix of the len packed letters before positions a_end and b_end
+ */
+inline int packed_common_suffix_len(uintptr_t a_end, uintptr_t b_end, int len) {
+    for (int i = 0; i < len; i += PACKED_WORD_LETTERS) {
+        int letters_count = len - i < PACKED_WORD_LETTERS ? len - i : PACKED_WORD_LETTERS;
+        uint64_t mismatches = load_packed_letters(a_end - i - letters_count, letters_count) ^
+                              load_packed_letters(b_end - i - letters_count, letters_count);
+        if (mismatches)
+            return i + letters_count - 1 - ((63 - __builtin_clzll(mismatches)) >> 1);
+    }
+    return len;
+}
+
+#endif //SEQUENCE_COMPARE_H
@@ -3,12 +3,40 @@
  */
 
 #include "time_profile.h"
+#include <atomic>
 #include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <new>
+#include <thread>
 #include <vector>
 #include <map>
+#include <sys/resource.h>
 
 using namespace std;
 
+struct PhaseRecord {
+    string name;
+    double wall_seconds;
+    double cpu_seconds;
+    long peak_rss_kb;
+    long allocations;
+    long nodes_before;
+    long edges_before;
+    long nodes_after;
+    long edges_after;
+};
+
+static atomic<bool> count_allocations{false}; // read by operator new on every thread
+static atomic<long> allocations_count{0};
+static function<void(long &, long &)> phase_graph_size;
+static vector<PhaseRecord> phases;
+static chrono::steady_clock::time_point phase_wall_start, profile_wall_start;
+static double phase_cpu_start;
+static long phase_allocations_start;
+static thread::id profile_thread; // only the phases of this thread are recorded
+
 auto times = map<string, vector<chrono::milliseconds>>();
 
 void add_time_c(const string &caller_name) {
@@ -22,7 +50,7 @@ void add_time_c(const string &caller_name) {
 
 string get_times_str_c(const string &caller_name, bool free_space) {
     string res;
-    for (int i = 1; i < times[caller_name].size(); i++)
+    for (size_t i = 1; i < times[caller_name].size(); i++)
         res += to_string(times[caller_name][i].count() - times[caller_name][i - 1].count()) + " ";
     if (free_space)
         times.erase(caller_name);
@@ -36,4 +64,83 @@ long last_time_c(const string &caller_name) {
 
 void erase_times_c(const string &caller_name) {
     times.erase(caller_name);
-}
\ No newline at end of file
+}
+
+void *operator new(size_t size) {
+    if (count_allocations.load(memory_order_relaxed))
+        allocations_count.fetch_add(1, memory_order_relaxed);
+    void *memory = malloc(size ? size : 1);
+    if (!memory)
+        throw bad_alloc();
+    return memory;
+}
+
+void operator delete(void *memory) noexcept {
+    free(memory);
+}
+
+static double cpu_seconds() {
+    timespec cpu_time{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_time);
+    return cpu_time.tv_sec + cpu_time.tv_nsec / 1e9;
+}
+
+static long peak_rss_kb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+void enable_phase_profile(const function<void(long &, long &)> &graph_size) {
+    phase_graph_size = graph_size;
+    profile_thread = this_thread::get_id();
+    profile_wall_start = chrono::steady_clock::now();
+    count_allocations.store(true);
+}
+
+bool phase_profile_enabled() {
+    return count_allocations.load(memory_order_relaxed);
+}
+
+void begin_phase(const string &name) {
+    if (!count_allocations.load(memory_order_relaxed) || this_thread::get_id() != profile_thread)
+        return;
+    PhaseRecord phase{};
+    phase.name = name;
+    phase_graph_size(phase.nodes_before, phase.edges_before);
+    phases.push_back(phase);
+    phase_allocations_start = allocations_count;
+    phase_cpu_start = cpu_seconds();
+    phase_wall_start = chrono::steady_clock::now();
+}
+
+void end_phase() {
+    if (!count_allocations.load(memory_order_relaxed) || phases.empty() || this_thread::get_id() != profile_thread)
+        return;
+    PhaseRecord &phase = phases.back();
+    phase.wall_seconds = chrono::duration<double>(chrono::steady_clock::now() - phase_wall_start).count();
+    phase.cpu_seconds = cpu_seconds() - phase_cpu_start;
+    phase.allocations = allocations_count - phase_allocations_start;
+    phase.peak_rss_kb = peak_rss_kb();
+    phase_graph_size(phase.nodes_after, phase.edges_after);
+}
+
+bool write_phase_profile(const char *file_name) {
+    FILE *file = fopen(file_name, "w");
+    if (!file)
+        return false;
+    fprintf(file, "{\n  \"total_wall_seconds\": %.6f,\n  \"total_cpu_seconds\": %.6f,\n  \"peak_rss_kb\": %ld,\n"
+                  "  \"phases\": [",
+            chrono::duration<double>(chrono::steady_clock::now() - profile_wall_start).count(), cpu_seconds(),
+            peak_rss_kb());
+    for (size_t i = 0; i < phases.size(); ++i) {
+        const PhaseRecord &phase = phases[i];
+        fprintf(file, "%s\n    {\"name\": \"%s\", \"wall_seconds\": %.6f, \"cpu_seconds\": %.6f, "
+                      "\"peak_rss_kb\": %ld, \"allocations\": %ld, \"nodes_before\": %ld, \"edges_before\": %ld, "
+                      "\"nodes_after\": %ld, \"edges_after\": %ld}",
+                i == 0 ? "" : ",", phase.name.c_str(), phase.wall_seconds, phase.cpu_seconds, phase.peak_rss_kb,
+                phase.allocations, phase.nodes_before, phase.edges_before, phase.nodes_after, phase.edges_after);
+    }
+    fprintf(file, "\n  ]\n}\n");
+    return fclose(file) == 0;
+}
@@ -2,6 +2,7 @@
  * @author Hassan Nikaein
  */
 
+#include <functional>
 #include <string>
 
 #ifndef TIME_PROFILE_H
@@ -15,6 +16,29 @@ long last_time_c(const std::string &caller_name);
 
 void erase_times_c(const std::string &caller_name);
 
+/**
+ * starts recording phases; graph_size(nodes, edges) is called at the start and end of each phase. Allocations are
+ * counted from here on.
+ */
+void enable_phase_profile(const std::function<void(long &, long &)> &graph_size);
+
+bool phase_profile_enabled();
+
+/**
+ * starts a phase, which lasts until the next end_phase(); does nothing unless profiling is enabled, or on other threads
+ * than the one that enabled it
+ */
+void begin_phase(const std::string &name);
+
+void end_phase();
+
+/**
+ * writes the wall and CPU time, peak resident memory, allocation count and graph size before and after of every
+ * recorded phase to file_name as JSON
+ * @return false if the file could not be written
+ */
+bool write_phase_profile(const char *file_name);
+
 #define add_time() add_time_c(string(__func__))
 #define atomic_add_time() add_time_c(string(__func__) + to_string(call_id))
 #define get_times_str(x) get_times_str_c(string(__func__),x).c_str()
@@ -0,0 +1,32 @@
+/**
+ * @author Hassan Nikaein
+ */
+
+#include <algorithm>
+#include <vector>
+
+#ifndef UNION_FIND_H
+#define UNION_FIND_H
+
+/**
+ * @return the root of the set of index in a union-find forest, halving the path to it on the way
+ */
+inline long find_root(std::vector<long> &parents, long index) {
+    while (parents[index] != index) {
+        parents[index] = parents[parents[index]];
+        index = parents[index];
+    }
+    return index;
+}
+
+/**
+ * joins the sets of two indices, the larger root going under the smaller one, so every set is rooted at its smallest
+ * index
+ */
+inline void unite(std::vector<long> &parents, long first_index, long second_index) {
+    long first_root = find_root(parents, first_index), second_root = find_root(parents, second_index);
+    if (first_root != second_root)
+        parents[std::max(first_root, second_root)] = std::min(first_root, second_root);
+}
+
+#endif //UNION_FIND_H